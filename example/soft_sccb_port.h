@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2018-11-08     balanceTWK   first version
+ */
+
+#ifndef __SOFT_SCCB_PORT_H__
+#define __SOFT_SCCB_PORT_H__
+
+/*
+ * Inline line primitives for RT_SCCB_USING_INLINE_PORT on STM32. The pins
+ * are the compile-time BSP_SCCB_SCL_PIN/BSP_SCCB_SDA_PIN, numbered like
+ * drv_gpio (port index * 16 + pin), and are driven through BSRR/IDR
+ * directly instead of rt_pin_write()/rt_pin_read().
+ */
+
+#include <rtthread.h>
+#include <board.h>
+#include "soft_sccb_stm32_port.h"
+
+rt_inline void sccb_port_set_sda(void *data, rt_int32_t state)
+{
+    SCCB_PIN_PORT(BSP_SCCB_SDA_PIN)->BSRR = state ? SCCB_PIN_MASK(BSP_SCCB_SDA_PIN) :
+                                            SCCB_PIN_MASK(BSP_SCCB_SDA_PIN) << 16;
+}
+
+rt_inline void sccb_port_set_scl(void *data, rt_int32_t state)
+{
+    SCCB_PIN_PORT(BSP_SCCB_SCL_PIN)->BSRR = state ? SCCB_PIN_MASK(BSP_SCCB_SCL_PIN) :
+                                            SCCB_PIN_MASK(BSP_SCCB_SCL_PIN) << 16;
+}
+
+rt_inline rt_int32_t sccb_port_get_sda(void *data)
+{
+    return (SCCB_PIN_PORT(BSP_SCCB_SDA_PIN)->IDR & SCCB_PIN_MASK(BSP_SCCB_SDA_PIN)) != 0;
+}
+
+rt_inline rt_int32_t sccb_port_get_scl(void *data)
+{
+    return (SCCB_PIN_PORT(BSP_SCCB_SCL_PIN)->IDR & SCCB_PIN_MASK(BSP_SCCB_SCL_PIN)) != 0;
+}
+
+#define SCCB_PORT_HAS_SET_LINES
+
+/* one BSRR write when both pins share a port, the test folds at compile time */
+
+rt_inline void sccb_port_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    rt_uint32_t set = 0, reset = 0;
+
+    if (mask & RT_SCCB_LINE_SCL)
+    {
+        if (values & RT_SCCB_LINE_SCL)
+            set   |= SCCB_PIN_MASK(BSP_SCCB_SCL_PIN);
+        else
+            reset |= SCCB_PIN_MASK(BSP_SCCB_SCL_PIN);
+    }
+    if (mask & RT_SCCB_LINE_SDA)
+    {
+        if (values & RT_SCCB_LINE_SDA)
+            set   |= SCCB_PIN_MASK(BSP_SCCB_SDA_PIN);
+        else
+            reset |= SCCB_PIN_MASK(BSP_SCCB_SDA_PIN);
+    }
+    if (SCCB_PIN_PORT(BSP_SCCB_SCL_PIN) == SCCB_PIN_PORT(BSP_SCCB_SDA_PIN))
+    {
+        SCCB_PIN_PORT(BSP_SCCB_SCL_PIN)->BSRR = set | (reset << 16);
+    }
+    else
+    {
+        if (mask & RT_SCCB_LINE_SCL && !(values & RT_SCCB_LINE_SCL))
+            sccb_port_set_scl(data, 0);
+        if (mask & RT_SCCB_LINE_SDA)
+            sccb_port_set_sda(data, values & RT_SCCB_LINE_SDA);
+        if (mask & RT_SCCB_LINE_SCL && (values & RT_SCCB_LINE_SCL))
+            sccb_port_set_scl(data, 1);
+    }
+}
+
+rt_inline void sccb_port_udelay(rt_uint32_t us)
+{
+    stm32_udelay(us);
+}
+
+#define SCCB_PORT_HAS_NDELAY
+
+rt_inline void sccb_port_ndelay(rt_uint32_t ns)
+{
+    stm32_ndelay(ns);
+}
+
+#endif
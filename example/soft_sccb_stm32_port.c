@@ -10,6 +10,9 @@
 
 #include <board.h>
 #include "soft_sccb_stm32_port.h"
+#if defined(BSP_SCCB_WAVE_TIMER) || defined(BSP_SCCB_IRQ_TIMER) || defined(BSP_SCCB_VSYNC_PIN)
+#include <rtdevice.h>
+#endif
 
 #ifdef PKG_USING_SOFT_SCCB
 
@@ -75,6 +78,36 @@ static void stm32_set_scl(void *data, rt_int32_t state)
     }
 }
 
+/**
+ * This function sets both pins with one BSRR write. Only installed when
+ * scl and sda are on the same GPIO port.
+ *
+ * @param Stm32 config class.
+ * @param The RT_SCCB_LINE_* lines to drive.
+ * @param The line states.
+ */
+static void stm32_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    struct stm32_soft_sccb_config* cfg = (struct stm32_soft_sccb_config*)data;
+    rt_uint32_t set = 0, reset = 0;
+
+    if (mask & RT_SCCB_LINE_SCL)
+    {
+        if (values & RT_SCCB_LINE_SCL)
+            set   |= SCCB_PIN_MASK(cfg->scl);
+        else
+            reset |= SCCB_PIN_MASK(cfg->scl);
+    }
+    if (mask & RT_SCCB_LINE_SDA)
+    {
+        if (values & RT_SCCB_LINE_SDA)
+            set   |= SCCB_PIN_MASK(cfg->sda);
+        else
+            reset |= SCCB_PIN_MASK(cfg->sda);
+    }
+    SCCB_PIN_PORT(cfg->scl)->BSRR = set | (reset << 16);
+}
+
 /**
  * This function gets the sda pin state.
  *
@@ -97,17 +130,15 @@ static rt_int32_t stm32_get_scl(void *data)
     return rt_pin_read(cfg->scl);
 }
 /**
- * The time delay function.
+ * This function spins until SysTick has counted the given number of ticks.
  *
- * @param microseconds.
+ * @param SysTick ticks.
  */
-static void stm32_udelay(rt_uint32_t us)
+static void stm32_systick_wait(rt_uint32_t ticks)
 {
-    rt_uint32_t ticks;
     rt_uint32_t told, tnow, tcnt = 0;
     rt_uint32_t reload = SysTick->LOAD;
 
-    ticks = us * reload / (1000000 / RT_TICK_PER_SECOND);
     told = SysTick->VAL;
     while (1)
     {
@@ -131,6 +162,245 @@ static void stm32_udelay(rt_uint32_t us)
     }
 }
 
+/**
+ * The time delay function, also used by the inline port.
+ *
+ * @param microseconds.
+ */
+void stm32_udelay(rt_uint32_t us)
+{
+    stm32_systick_wait(us * SysTick->LOAD / (1000000 / RT_TICK_PER_SECOND));
+}
+
+/**
+ * The nanosecond delay function for timing profiles.
+ *
+ * @param nanoseconds.
+ */
+void stm32_ndelay(rt_uint32_t ns)
+{
+    stm32_systick_wait((rt_uint64_t)ns * SysTick->LOAD / (1000000000 / RT_TICK_PER_SECOND));
+}
+
+/**
+ * The bus statistics timestamp, refined below the tick with SysTick.
+ *
+ * @return microseconds.
+ */
+rt_uint32_t rt_sccb_get_us(void)
+{
+    rt_uint32_t reload = SysTick->LOAD;
+    rt_uint32_t val;
+    rt_tick_t tick;
+
+    do
+    {
+        tick = rt_tick_get();
+        val  = SysTick->VAL;
+    } while (tick != rt_tick_get());
+
+    return tick * (1000000 / RT_TICK_PER_SECOND) +
+           (rt_uint32_t)((rt_uint64_t)(reload - val) * (1000000 / RT_TICK_PER_SECOND) / (reload + 1));
+}
+
+/**
+ * This function drives several pins of one GPIO port with one BSRR write,
+ * for a multi-lane bus.
+ *
+ * @param The GPIO_TypeDef of the port.
+ * @param The pin mask to drive.
+ * @param The pin states.
+ */
+void stm32_lanes_set_port(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    ((GPIO_TypeDef *)data)->BSRR = (values & mask) | ((~values & mask) << 16);
+}
+
+/**
+ * This function samples every pin of one GPIO port, for a multi-lane bus.
+ *
+ * @param The GPIO_TypeDef of the port.
+ *
+ * @return The pin states.
+ */
+rt_uint32_t stm32_lanes_get_port(void *data)
+{
+    return ((GPIO_TypeDef *)data)->IDR;
+}
+
+#ifdef BSP_SCCB_WAVE_TIMER
+/*
+ * Waveform playback from a periodic hwtimer, BSP_SCCB_WAVE_TIMER names the
+ * timer device, e.g. "timer6". The timer callback runs in interrupt context
+ * and plays one slot per period, the caller sleeps until the last one.
+ */
+static rt_device_t wave_timer;
+static struct rt_semaphore wave_done;
+static struct rt_sccb_wave *wave_playing;
+
+static rt_err_t stm32_wave_timeout(rt_device_t dev, rt_size_t size)
+{
+    if (rt_sccb_wave_tick(wave_playing))
+    {
+        rt_device_control(wave_timer, HWTIMER_CTRL_STOP, RT_NULL);
+        rt_sem_release(&wave_done);
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * This function clocks a waveform out from the timer interrupt.
+ *
+ * @param The waveform.
+ *
+ * @return RT_EOK when the waveform was played, -RT_EIO if the timer failed.
+ */
+static rt_err_t stm32_wave_play(struct rt_sccb_wave *wave)
+{
+    rt_hwtimerval_t period;
+
+    period.sec  = 0;
+    period.usec = (wave->slot_ns + 999) / 1000;
+    if (period.usec == 0)
+        period.usec = 1;
+
+    wave_playing = wave;
+    if (rt_device_write(wave_timer, 0, &period, sizeof(period)) != sizeof(period))
+        return -RT_EIO;
+    rt_sem_take(&wave_done, RT_WAITING_FOREVER);
+
+    return RT_EOK;
+}
+
+static rt_err_t stm32_wave_timer_init(void)
+{
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_PERIOD;
+    rt_uint32_t freq = 1000000;
+
+    wave_timer = rt_device_find(BSP_SCCB_WAVE_TIMER);
+    if (wave_timer == RT_NULL)
+        return -RT_ENOSYS;
+    if (rt_device_open(wave_timer, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+        return -RT_EIO;
+    rt_device_set_rx_indicate(wave_timer, stm32_wave_timeout);
+    rt_device_control(wave_timer, HWTIMER_CTRL_FREQ_SET, &freq);
+    rt_device_control(wave_timer, HWTIMER_CTRL_MODE_SET, &mode);
+
+    return rt_sem_init(&wave_done, "sccb_wv", 0, RT_IPC_FLAG_FIFO);
+}
+#endif /* BSP_SCCB_WAVE_TIMER */
+
+#ifdef BSP_SCCB_IRQ_TIMER
+/*
+ * Interrupt-driven engine on a periodic hwtimer, BSP_SCCB_IRQ_TIMER names
+ * the timer device. Every timer interrupt advances the bus by one phase,
+ * the calling thread sleeps meanwhile instead of spinning in stm32_udelay.
+ */
+static rt_device_t irq_timer;
+
+static rt_err_t stm32_irq_timeout(rt_device_t dev, rt_size_t size)
+{
+    rt_sccb_fsm_tick(&sccb_obj.ops);
+
+    return RT_EOK;
+}
+
+/**
+ * This function starts the bus timer.
+ *
+ * @param Stm32 config class.
+ * @param The timer period in nanoseconds.
+ *
+ * @return RT_EOK on success, -RT_EIO if the timer could not be started.
+ */
+static rt_err_t stm32_timer_start(void *data, rt_uint32_t period_ns)
+{
+    rt_hwtimerval_t period;
+
+    period.sec  = 0;
+    period.usec = (period_ns + 999) / 1000;
+    if (period.usec == 0)
+        period.usec = 1;
+
+    if (rt_device_write(irq_timer, 0, &period, sizeof(period)) != sizeof(period))
+        return -RT_EIO;
+
+    return RT_EOK;
+}
+
+/**
+ * This function stops the bus timer, from its own interrupt.
+ *
+ * @param Stm32 config class.
+ */
+static void stm32_timer_stop(void *data)
+{
+    rt_device_control(irq_timer, HWTIMER_CTRL_STOP, RT_NULL);
+}
+
+static rt_err_t stm32_irq_timer_init(void)
+{
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_PERIOD;
+    rt_uint32_t freq = 1000000;
+
+    irq_timer = rt_device_find(BSP_SCCB_IRQ_TIMER);
+    if (irq_timer == RT_NULL)
+        return -RT_ENOSYS;
+    if (rt_device_open(irq_timer, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+        return -RT_EIO;
+    rt_device_set_rx_indicate(irq_timer, stm32_irq_timeout);
+    rt_device_control(irq_timer, HWTIMER_CTRL_FREQ_SET, &freq);
+    rt_device_control(irq_timer, HWTIMER_CTRL_MODE_SET, &mode);
+
+    sccb_obj.ops.timer_start = stm32_timer_start;
+    sccb_obj.ops.timer_stop  = stm32_timer_stop;
+    sccb_obj.ops.fsm         = &sccb_obj.fsm;
+
+    return RT_EOK;
+}
+#endif /* BSP_SCCB_IRQ_TIMER */
+
+#ifdef BSP_SCCB_VSYNC_PIN
+/*
+ * Frame-synchronized commit, BSP_SCCB_VSYNC_PIN is the sensor VSYNC input.
+ * Register writes staged during a frame go out at its start of blanking.
+ */
+static void stm32_vsync_isr(void *args)
+{
+    rt_sccb_stage_trigger(&sccb_obj.stage);
+}
+
+static rt_err_t stm32_vsync_init(void)
+{
+    rt_err_t result;
+
+    rt_sccb_stage_init(&sccb_obj.stage, &sccb_obj.sccb_bus, BSP_SCCB_STAGE_BUDGET_US);
+    result = rt_sccb_stage_start(&sccb_obj.stage, "sccb_st", 1024, 5);
+    if (result != RT_EOK)
+        return result;
+
+    rt_pin_mode(BSP_SCCB_VSYNC_PIN, PIN_MODE_INPUT);
+    result = rt_pin_attach_irq(BSP_SCCB_VSYNC_PIN, PIN_IRQ_MODE_RISING,
+                               stm32_vsync_isr, RT_NULL);
+    if (result != RT_EOK)
+        return result;
+
+    return rt_pin_irq_enable(BSP_SCCB_VSYNC_PIN, PIN_IRQ_ENABLE);
+}
+
+/**
+ * This function returns the VSYNC stage of the bus, for the sensor driver
+ * to stage its per-frame settings into.
+ *
+ * @return the stage.
+ */
+struct rt_sccb_stage *stm32_sccb_stage(void)
+{
+    return &sccb_obj.stage;
+}
+#endif /* BSP_SCCB_VSYNC_PIN */
+
 static const struct rt_sccb_ops stm32_bit_ops_default =
 {
     .data     = RT_NULL,
@@ -138,7 +408,9 @@ static const struct rt_sccb_ops stm32_bit_ops_default =
     .set_scl  = stm32_set_scl,
     .get_sda  = stm32_get_sda,
     .get_scl  = stm32_get_scl,
+    .set_lines = stm32_set_lines,
     .udelay   = stm32_udelay,
+    .ndelay   = stm32_ndelay,
     .delay_us = 1,
     .timeout  = 100
 };
@@ -179,11 +451,30 @@ int rt_hw_sccb_init(void)
 
     sccb_obj.ops = stm32_bit_ops_default;
     sccb_obj.ops.data = (void*)&soft_sccb_config;
-    sccb_obj.sccb_bus.priv = &sccb_obj.ops;
+    if (SCCB_PIN_PORT(soft_sccb_config.scl) != SCCB_PIN_PORT(soft_sccb_config.sda))
+        sccb_obj.ops.set_lines = RT_NULL;
     stm32_sccb_gpio_init(&sccb_obj);
+#ifdef BSP_SCCB_WAVE_TIMER
+    result = stm32_wave_timer_init();
+    RT_ASSERT(result == RT_EOK);
+    sccb_obj.wave.ops  = &sccb_obj.ops;
+    sccb_obj.wave.play = stm32_wave_play;
+    sccb_obj.sccb_bus.priv = &sccb_obj.wave;
+    result = rt_sccb_add_wave_bus(&sccb_obj.sccb_bus, soft_sccb_config.bus_name);
+#else
+#ifdef BSP_SCCB_IRQ_TIMER
+    result = stm32_irq_timer_init();
+    RT_ASSERT(result == RT_EOK);
+#endif
+    sccb_obj.sccb_bus.priv = &sccb_obj.ops;
     result = rt_sccb_add_bus(&sccb_obj.sccb_bus, soft_sccb_config.bus_name);
+#endif
     RT_ASSERT(result == RT_EOK);
     stm32_sccb_bus_unlock(&soft_sccb_config);
+#ifdef BSP_SCCB_VSYNC_PIN
+    result = stm32_vsync_init();
+    RT_ASSERT(result == RT_EOK);
+#endif
 
     LOG_D("software simulation %s init done, pin scl: %d, pin sda %d",
     soft_sccb_config.bus_name,
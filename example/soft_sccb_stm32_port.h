@@ -15,6 +15,12 @@
 #include <rthw.h>
 #include "soft_sccb.h"
 #include "soft_sccb_core.h"
+#ifdef BSP_SCCB_WAVE_TIMER
+#include "soft_sccb_wave.h"
+#endif
+#ifdef BSP_SCCB_VSYNC_PIN
+#include "soft_sccb_stage.h"
+#endif
 
 /* stm32 config class */
 struct stm32_soft_sccb_config
@@ -28,8 +34,21 @@ struct stm32_sccb
 {
     struct rt_sccb_ops ops;
     struct rt_sccb_bus_device sccb_bus;
+#ifdef BSP_SCCB_WAVE_TIMER
+    struct rt_sccb_wave wave;       /* waveform playback from a hwtimer */
+#endif
+#ifdef BSP_SCCB_IRQ_TIMER
+    struct rt_sccb_fsm fsm;         /* interrupt-driven engine on a hwtimer */
+#endif
+#ifdef BSP_SCCB_VSYNC_PIN
+    struct rt_sccb_stage stage;     /* staged writes, committed at VSYNC */
+#endif
 };
 
+/* GPIO port and pin mask of a drv_gpio pin number (port index * 16 + pin) */
+#define SCCB_PIN_PORT(pin)      ((GPIO_TypeDef *)(GPIOA_BASE + (0x400u * ((pin) >> 4))))
+#define SCCB_PIN_MASK(pin)      (1u << ((pin) & 0x0f))
+
 #define SCCB_BUS_CONFIG                                  \
     {                                                    \
         .scl = BSP_SCCB_SCL_PIN,                         \
@@ -37,6 +56,19 @@ struct stm32_sccb
         .bus_name = "sccb",                              \
     }
 
+#ifdef BSP_SCCB_VSYNC_PIN
+#ifndef BSP_SCCB_STAGE_BUDGET_US
+#define BSP_SCCB_STAGE_BUDGET_US 500     /* vertical blanking left for the commit */
+#endif
+struct rt_sccb_stage *stm32_sccb_stage(void);
+#endif
+
 int rt_hw_sccb_init(void);
+void stm32_udelay(rt_uint32_t us);
+void stm32_ndelay(rt_uint32_t ns);
+
+/* rt_sccb_lanes_ops port hooks, data is the GPIO_TypeDef of the port */
+void stm32_lanes_set_port(void *data, rt_uint32_t mask, rt_uint32_t values);
+rt_uint32_t stm32_lanes_get_port(void *data);
 
 #endif
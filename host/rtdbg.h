@@ -0,0 +1,35 @@
+/*
+ * Host-side shim of rtdbg.h, logs go to stderr so program output stays
+ * machine-readable.
+ */
+
+#ifndef __RTDBG_HOST_H__
+#define __RTDBG_HOST_H__
+
+#include <rtthread.h>
+
+#define DBG_ERROR           0
+#define DBG_WARNING         1
+#define DBG_INFO            2
+#define DBG_LOG             3
+
+#ifndef DBG_TAG
+#define DBG_TAG             "DBG"
+#endif
+#ifndef DBG_LVL
+#define DBG_LVL             DBG_WARNING
+#endif
+
+#define dbg_log_line(lvl, level, fmt, ...)                                  \
+    do                                                                      \
+    {                                                                       \
+        if ((level) <= DBG_LVL)                                             \
+            fprintf(stderr, "[" lvl "/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__); \
+    } while (0)
+
+#define LOG_D(fmt, ...)     dbg_log_line("D", DBG_LOG, fmt, ##__VA_ARGS__)
+#define LOG_I(fmt, ...)     dbg_log_line("I", DBG_INFO, fmt, ##__VA_ARGS__)
+#define LOG_W(fmt, ...)     dbg_log_line("W", DBG_WARNING, fmt, ##__VA_ARGS__)
+#define LOG_E(fmt, ...)     dbg_log_line("E", DBG_ERROR, fmt, ##__VA_ARGS__)
+
+#endif
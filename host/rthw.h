@@ -0,0 +1,22 @@
+/*
+ * Host-side shim of rthw.h, interrupt masking maps to one global
+ * recursive lock.
+ */
+
+#ifndef __RTHW_HOST_H__
+#define __RTHW_HOST_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+rt_base_t rt_hw_interrupt_disable(void);
+void rt_hw_interrupt_enable(rt_base_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
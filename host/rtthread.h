@@ -0,0 +1,292 @@
+/*
+ * Host-side shim of the RT-Thread primitives used by soft_sccb, so the
+ * library and the simulated port can be built and run natively on Linux.
+ * Only the subset of the kernel API the package touches is provided.
+ */
+
+#ifndef __RTTHREAD_HOST_H__
+#define __RTTHREAD_HOST_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int8_t                  rt_int8_t;
+typedef uint8_t                 rt_uint8_t;
+typedef int16_t                 rt_int16_t;
+typedef uint16_t                rt_uint16_t;
+typedef int32_t                 rt_int32_t;
+typedef uint32_t                rt_uint32_t;
+typedef int64_t                 rt_int64_t;
+typedef uint64_t                rt_uint64_t;
+typedef int                     rt_bool_t;
+typedef long                    rt_base_t;
+typedef unsigned long           rt_ubase_t;
+typedef rt_base_t               rt_err_t;
+typedef rt_uint32_t             rt_tick_t;
+typedef rt_ubase_t              rt_size_t;
+typedef rt_base_t               rt_off_t;
+
+#define RT_TRUE                 1
+#define RT_FALSE                0
+#define RT_NULL                 ((void *)0)
+
+#define RT_EOK                  0
+#define RT_ERROR                1
+#define RT_ETIMEOUT             2
+#define RT_EFULL                3
+#define RT_EEMPTY               4
+#define RT_ENOMEM               5
+#define RT_ENOSYS               6
+#define RT_EBUSY                7
+#define RT_EIO                  8
+#define RT_EINTR                9
+#define RT_EINVAL               10
+
+#define RT_NAME_MAX             8
+#define RT_TICK_PER_SECOND      1000
+#define RT_THREAD_PRIORITY_MAX  32
+#define RT_WAITING_FOREVER      -1
+#define RT_WAITING_NO           0
+
+#define RT_THREAD_CTRL_CHANGE_PRIORITY  0x02
+
+#define RT_IPC_FLAG_FIFO        0x00
+#define RT_IPC_FLAG_PRIO        0x01
+
+#define RT_EVENT_FLAG_AND       0x01
+#define RT_EVENT_FLAG_OR        0x02
+#define RT_EVENT_FLAG_CLEAR     0x04
+
+#define RT_DEVICE_FLAG_RDONLY   0x001
+#define RT_DEVICE_FLAG_WRONLY   0x002
+#define RT_DEVICE_FLAG_RDWR     0x003
+
+#define rt_inline               static __inline
+#define RT_WEAK                 __attribute__((weak))
+#define RT_ALIGN(size, align)   (((size) + (align) - 1) & ~((align) - 1))
+
+#define RT_ASSERT(EX)                                                       \
+    do                                                                      \
+    {                                                                       \
+        if (!(EX))                                                          \
+        {                                                                   \
+            fprintf(stderr, "(%s) assertion failed at %s:%d\n",             \
+                    #EX, __FUNCTION__, __LINE__);                           \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+/* auto-initialization is a no-op on the host */
+#define INIT_BOARD_EXPORT(fn)
+#define INIT_DEVICE_EXPORT(fn)
+#define INIT_COMPONENT_EXPORT(fn)
+#define INIT_APP_EXPORT(fn)
+
+/* there is no shell, a command is exported as msh_<command>() to call directly */
+#define RT_USING_FINSH
+#define FINSH_USING_MSH
+#define MSH_CMD_EXPORT(command, desc)                                       \
+    int msh_##command(int argc, char **argv) { return command(argc, argv); }
+#define MSH_CMD_EXPORT_ALIAS(command, alias, desc)                          \
+    int msh_##alias(int argc, char **argv) { return command(argc, argv); }
+
+#define rt_kprintf              printf
+#define rt_snprintf             snprintf
+#define rt_vsnprintf            vsnprintf
+#define rt_memset               memset
+#define rt_memcpy               memcpy
+#define rt_memcmp               memcmp
+#define rt_strcmp               strcmp
+#define rt_strncmp              strncmp
+#define rt_strncpy              strncpy
+
+/* double list */
+struct rt_list_node
+{
+    struct rt_list_node *next;
+    struct rt_list_node *prev;
+};
+typedef struct rt_list_node rt_list_t;
+
+#define rt_container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - (unsigned long)(&((type *)0)->member)))
+#define rt_list_entry(node, type, member) \
+    rt_container_of(node, type, member)
+
+rt_inline void rt_list_init(rt_list_t *l)
+{
+    l->next = l->prev = l;
+}
+
+rt_inline void rt_list_insert_after(rt_list_t *l, rt_list_t *n)
+{
+    l->next->prev = n;
+    n->next = l->next;
+    l->next = n;
+    n->prev = l;
+}
+
+rt_inline void rt_list_insert_before(rt_list_t *l, rt_list_t *n)
+{
+    l->prev->next = n;
+    n->prev = l->prev;
+    l->prev = n;
+    n->next = l;
+}
+
+rt_inline void rt_list_remove(rt_list_t *n)
+{
+    n->next->prev = n->prev;
+    n->prev->next = n->next;
+    n->next = n->prev = n;
+}
+
+rt_inline int rt_list_isempty(const rt_list_t *l)
+{
+    return l->next == l;
+}
+
+struct rt_object
+{
+    char        name[RT_NAME_MAX];
+    rt_list_t   list;
+};
+
+/* thread */
+struct rt_thread
+{
+    struct rt_object parent;
+    rt_uint8_t  current_priority;
+    void (*entry)(void *parameter);
+    void        *parameter;
+    void        *host;              /* pthread handle */
+    rt_uint8_t  suspended;          /* parked in rt_schedule() until resumed */
+};
+typedef struct rt_thread *rt_thread_t;
+
+/* IPC objects, backed by pthread primitives */
+struct rt_mutex
+{
+    struct rt_object parent;
+    void        *host;
+    rt_thread_t owner;
+    rt_uint8_t  hold;
+};
+typedef struct rt_mutex *rt_mutex_t;
+
+struct rt_semaphore
+{
+    struct rt_object parent;
+    void        *host;
+    rt_uint16_t value;
+};
+typedef struct rt_semaphore *rt_sem_t;
+
+struct rt_event
+{
+    struct rt_object parent;
+    void        *host;
+    rt_uint32_t set;
+};
+typedef struct rt_event *rt_event_t;
+
+/* device */
+enum rt_device_class_type
+{
+    RT_Device_Class_Char = 0,
+    RT_Device_Class_Block,
+    RT_Device_Class_NetIf,
+    RT_Device_Class_MTD,
+    RT_Device_Class_CAN,
+    RT_Device_Class_RTC,
+    RT_Device_Class_Sound,
+    RT_Device_Class_Graphic,
+    RT_Device_Class_I2CBUS,
+    RT_Device_Class_SCCB,
+    RT_Device_Class_Miscellaneous,
+    RT_Device_Class_Unknown
+};
+
+typedef struct rt_device *rt_device_t;
+struct rt_device
+{
+    struct rt_object          parent;
+    enum rt_device_class_type type;
+    rt_uint16_t               flag;
+
+    rt_err_t  (*init)   (rt_device_t dev);
+    rt_err_t  (*open)   (rt_device_t dev, rt_uint16_t oflag);
+    rt_err_t  (*close)  (rt_device_t dev);
+    rt_size_t (*read)   (rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+    rt_size_t (*write)  (rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+    rt_err_t  (*control)(rt_device_t dev, int cmd, void *args);
+
+    void                     *user_data;
+};
+
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags);
+rt_err_t rt_device_unregister(rt_device_t dev);
+rt_device_t rt_device_find(const char *name);
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg);
+
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag);
+rt_err_t rt_mutex_detach(rt_mutex_t mutex);
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time);
+rt_err_t rt_mutex_release(rt_mutex_t mutex);
+
+rt_err_t rt_sem_init(rt_sem_t sem, const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_detach(rt_sem_t sem);
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time);
+rt_err_t rt_sem_trytake(rt_sem_t sem);
+rt_err_t rt_sem_release(rt_sem_t sem);
+
+rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag);
+rt_err_t rt_event_detach(rt_event_t event);
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set);
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt,
+                       rt_int32_t timeout, rt_uint32_t *recved);
+
+rt_tick_t rt_tick_get(void);
+rt_int32_t rt_tick_from_millisecond(rt_int32_t ms);
+
+rt_thread_t rt_thread_self(void);
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter),
+                             void *parameter, rt_uint32_t stack_size,
+                             rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name,
+                        void (*entry)(void *parameter), void *parameter,
+                        void *stack_start, rt_uint32_t stack_size,
+                        rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+rt_err_t rt_thread_yield(void);
+rt_err_t rt_thread_suspend(rt_thread_t thread);
+rt_err_t rt_thread_resume(rt_thread_t thread);
+rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg);
+void rt_schedule(void);
+
+/* host only: observe thread sleeps, e.g. to advance a simulated clock */
+void rt_host_delay_sethook(void (*hook)(rt_tick_t tick));
+/* host only: number of rt_mutex_take() calls so far */
+rt_uint32_t rt_host_mutex_takes(void);
+
+rt_uint8_t rt_interrupt_get_nest(void);
+void rt_interrupt_enter(void);
+void rt_interrupt_leave(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,510 @@
+/*
+ * Host-side implementation of the rtthread.h shim on top of POSIX
+ * threads. Ticks are milliseconds of CLOCK_MONOTONIC.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <rtthread.h>
+#include <rthw.h>
+
+static rt_list_t device_list = { &device_list, &device_list };
+static pthread_mutex_t device_list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t interrupt_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread rt_uint8_t interrupt_nest;
+
+static struct rt_thread main_thread = { { "main" }, RT_THREAD_PRIORITY_MAX / 2 };
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_cond = PTHREAD_COND_INITIALIZER;
+static __thread rt_thread_t current_thread;
+
+static void (*delay_hook)(rt_tick_t tick);
+static rt_uint32_t mutex_takes;
+
+struct host_sync
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+};
+
+static struct host_sync *host_sync_create(void)
+{
+    struct host_sync *sync = malloc(sizeof(struct host_sync));
+
+    RT_ASSERT(sync != RT_NULL);
+    pthread_mutex_init(&sync->lock, RT_NULL);
+    pthread_cond_init(&sync->cond, RT_NULL);
+
+    return sync;
+}
+
+static void host_sync_delete(struct host_sync *sync)
+{
+    pthread_cond_destroy(&sync->cond);
+    pthread_mutex_destroy(&sync->lock);
+    free(sync);
+}
+
+/* wait on the condition, RT_EOK or -RT_ETIMEOUT */
+static rt_err_t host_sync_wait(struct host_sync *sync, rt_int32_t time)
+{
+    struct timespec ts;
+
+    if (time == RT_WAITING_FOREVER)
+    {
+        pthread_cond_wait(&sync->cond, &sync->lock);
+
+        return RT_EOK;
+    }
+    if (time == RT_WAITING_NO)
+        return -RT_ETIMEOUT;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += time / RT_TICK_PER_SECOND;
+    ts.tv_nsec += (time % RT_TICK_PER_SECOND) * (1000000000L / RT_TICK_PER_SECOND);
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return (pthread_cond_timedwait(&sync->cond, &sync->lock, &ts) == ETIMEDOUT) ?
+           -RT_ETIMEOUT : RT_EOK;
+}
+
+static void object_init(struct rt_object *object, const char *name)
+{
+    rt_strncpy(object->name, name ? name : "", RT_NAME_MAX);
+    rt_list_init(&object->list);
+}
+
+/* device */
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags)
+{
+    if (rt_device_find(name) != RT_NULL)
+        return -RT_ERROR;
+
+    object_init(&dev->parent, name);
+    dev->flag = flags;
+    pthread_mutex_lock(&device_list_lock);
+    rt_list_insert_before(&device_list, &dev->parent.list);
+    pthread_mutex_unlock(&device_list_lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_device_unregister(rt_device_t dev)
+{
+    pthread_mutex_lock(&device_list_lock);
+    rt_list_remove(&dev->parent.list);
+    pthread_mutex_unlock(&device_list_lock);
+
+    return RT_EOK;
+}
+
+rt_device_t rt_device_find(const char *name)
+{
+    rt_list_t *node;
+    rt_device_t dev = RT_NULL;
+
+    pthread_mutex_lock(&device_list_lock);
+    for (node = device_list.next; node != &device_list; node = node->next)
+    {
+        rt_device_t d = rt_list_entry(node, struct rt_device, parent.list);
+        if (rt_strncmp(d->parent.name, name, RT_NAME_MAX) == 0)
+        {
+            dev = d;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&device_list_lock);
+
+    return dev;
+}
+
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    return dev->read ? dev->read(dev, pos, buffer, size) : 0;
+}
+
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    return dev->write ? dev->write(dev, pos, buffer, size) : 0;
+}
+
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg)
+{
+    return dev->control ? dev->control(dev, cmd, arg) : -RT_ENOSYS;
+}
+
+/* mutex, recursive like the kernel one */
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    (void)flag;
+    object_init(&mutex->parent, name);
+    mutex->host  = host_sync_create();
+    mutex->owner = RT_NULL;
+    mutex->hold  = 0;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+    host_sync_delete(mutex->host);
+    mutex->host = RT_NULL;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
+{
+    struct host_sync *sync = mutex->host;
+    rt_thread_t self = rt_thread_self();
+    rt_err_t ret = RT_EOK;
+
+    __atomic_fetch_add(&mutex_takes, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&sync->lock);
+    if (mutex->owner == self)
+    {
+        mutex->hold++;
+    }
+    else
+    {
+        while (mutex->owner != RT_NULL && ret == RT_EOK)
+            ret = host_sync_wait(sync, time);
+        if (ret == RT_EOK)
+        {
+            mutex->owner = self;
+            mutex->hold  = 1;
+        }
+    }
+    pthread_mutex_unlock(&sync->lock);
+
+    return ret;
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+    struct host_sync *sync = mutex->host;
+    rt_err_t ret = RT_EOK;
+
+    pthread_mutex_lock(&sync->lock);
+    if (mutex->owner != rt_thread_self())
+    {
+        ret = -RT_ERROR;
+    }
+    else if (--mutex->hold == 0)
+    {
+        mutex->owner = RT_NULL;
+        pthread_cond_signal(&sync->cond);
+    }
+    pthread_mutex_unlock(&sync->lock);
+
+    return ret;
+}
+
+/* semaphore */
+rt_err_t rt_sem_init(rt_sem_t sem, const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    (void)flag;
+    object_init(&sem->parent, name);
+    sem->host  = host_sync_create();
+    sem->value = value;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_detach(rt_sem_t sem)
+{
+    host_sync_delete(sem->host);
+    sem->host = RT_NULL;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
+{
+    struct host_sync *sync = sem->host;
+    rt_err_t ret = RT_EOK;
+
+    pthread_mutex_lock(&sync->lock);
+    while (sem->value == 0 && ret == RT_EOK)
+        ret = host_sync_wait(sync, time);
+    if (ret == RT_EOK)
+        sem->value--;
+    pthread_mutex_unlock(&sync->lock);
+
+    return ret;
+}
+
+rt_err_t rt_sem_trytake(rt_sem_t sem)
+{
+    return rt_sem_take(sem, RT_WAITING_NO);
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+    struct host_sync *sync = sem->host;
+
+    pthread_mutex_lock(&sync->lock);
+    sem->value++;
+    pthread_cond_signal(&sync->cond);
+    pthread_mutex_unlock(&sync->lock);
+
+    return RT_EOK;
+}
+
+/* event */
+rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag)
+{
+    (void)flag;
+    object_init(&event->parent, name);
+    event->host = host_sync_create();
+    event->set  = 0;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_event_detach(rt_event_t event)
+{
+    host_sync_delete(event->host);
+    event->host = RT_NULL;
+
+    return RT_EOK;
+}
+
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
+{
+    struct host_sync *sync = event->host;
+
+    pthread_mutex_lock(&sync->lock);
+    event->set |= set;
+    pthread_cond_broadcast(&sync->cond);
+    pthread_mutex_unlock(&sync->lock);
+
+    return RT_EOK;
+}
+
+static rt_bool_t event_match(rt_event_t event, rt_uint32_t set, rt_uint8_t opt)
+{
+    if (opt & RT_EVENT_FLAG_AND)
+        return (event->set & set) == set;
+
+    return (event->set & set) != 0;
+}
+
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt,
+                       rt_int32_t timeout, rt_uint32_t *recved)
+{
+    struct host_sync *sync = event->host;
+    rt_err_t ret = RT_EOK;
+
+    pthread_mutex_lock(&sync->lock);
+    while (!event_match(event, set, opt) && ret == RT_EOK)
+        ret = host_sync_wait(sync, timeout);
+    if (ret == RT_EOK)
+    {
+        if (recved)
+            *recved = event->set & set;
+        if (opt & RT_EVENT_FLAG_CLEAR)
+            event->set &= ~set;
+    }
+    pthread_mutex_unlock(&sync->lock);
+
+    return ret;
+}
+
+/* clock */
+rt_tick_t rt_tick_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_tick_t)(ts.tv_sec * RT_TICK_PER_SECOND +
+                       ts.tv_nsec / (1000000000L / RT_TICK_PER_SECOND));
+}
+
+rt_int32_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    if (ms < 0)
+        return RT_WAITING_FOREVER;
+
+    return (ms * RT_TICK_PER_SECOND + 999) / 1000;
+}
+
+/* thread */
+static void *thread_entry(void *parameter)
+{
+    rt_thread_t thread = parameter;
+
+    current_thread = thread;
+    thread->entry(thread->parameter);
+
+    return RT_NULL;
+}
+
+rt_thread_t rt_thread_self(void)
+{
+    if (current_thread == RT_NULL)
+        current_thread = &main_thread;
+
+    return current_thread;
+}
+
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name,
+                        void (*entry)(void *parameter), void *parameter,
+                        void *stack_start, rt_uint32_t stack_size,
+                        rt_uint8_t priority, rt_uint32_t tick)
+{
+    (void)stack_start;
+    (void)stack_size;
+    (void)tick;
+    object_init(&thread->parent, name);
+    thread->entry            = entry;
+    thread->parameter        = parameter;
+    thread->current_priority = priority;
+    thread->host             = RT_NULL;
+    thread->suspended        = 0;
+
+    return RT_EOK;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter),
+                             void *parameter, rt_uint32_t stack_size,
+                             rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = malloc(sizeof(struct rt_thread));
+
+    if (thread != RT_NULL)
+        rt_thread_init(thread, name, entry, parameter, RT_NULL, stack_size, priority, tick);
+
+    return thread;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    pthread_t *handle = malloc(sizeof(pthread_t));
+
+    if (handle == RT_NULL)
+        return -RT_ENOMEM;
+    thread->host = handle;
+    if (pthread_create(handle, RT_NULL, thread_entry, thread) != 0)
+        return -RT_ERROR;
+    pthread_detach(*handle);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    struct timespec ts;
+
+    if (delay_hook)
+        delay_hook(tick);
+
+    ts.tv_sec  = tick / RT_TICK_PER_SECOND;
+    ts.tv_nsec = (tick % RT_TICK_PER_SECOND) * (1000000000L / RT_TICK_PER_SECOND);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    return rt_thread_delay(rt_tick_from_millisecond(ms));
+}
+
+rt_err_t rt_thread_yield(void)
+{
+    sched_yield();
+
+    return RT_EOK;
+}
+
+/*
+ * suspend and resume only park a thread: rt_schedule() blocks the caller
+ * while it is suspended. Like on the kernel, a thread suspends itself with
+ * interrupts off and switches away with rt_schedule() once they are back on.
+ */
+rt_err_t rt_thread_suspend(rt_thread_t thread)
+{
+    pthread_mutex_lock(&sched_lock);
+    thread->suspended = 1;
+    pthread_mutex_unlock(&sched_lock);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_resume(rt_thread_t thread)
+{
+    pthread_mutex_lock(&sched_lock);
+    thread->suspended = 0;
+    pthread_cond_broadcast(&sched_cond);
+    pthread_mutex_unlock(&sched_lock);
+
+    return RT_EOK;
+}
+
+void rt_schedule(void)
+{
+    rt_thread_t self = rt_thread_self();
+
+    pthread_mutex_lock(&sched_lock);
+    while (self->suspended)
+        pthread_cond_wait(&sched_cond, &sched_lock);
+    pthread_mutex_unlock(&sched_lock);
+}
+
+/* host threads have no priority, the value is only recorded */
+rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
+{
+    if (cmd != RT_THREAD_CTRL_CHANGE_PRIORITY)
+        return -RT_ERROR;
+    thread->current_priority = *(rt_uint8_t *)arg;
+
+    return RT_EOK;
+}
+
+void rt_host_delay_sethook(void (*hook)(rt_tick_t tick))
+{
+    delay_hook = hook;
+}
+
+rt_uint32_t rt_host_mutex_takes(void)
+{
+    return __atomic_load_n(&mutex_takes, __ATOMIC_RELAXED);
+}
+
+/* interrupt */
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    pthread_mutex_lock(&interrupt_lock);
+
+    return 0;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    (void)level;
+    pthread_mutex_unlock(&interrupt_lock);
+}
+
+rt_uint8_t rt_interrupt_get_nest(void)
+{
+    return interrupt_nest;
+}
+
+void rt_interrupt_enter(void)
+{
+    interrupt_nest++;
+}
+
+void rt_interrupt_leave(void)
+{
+    interrupt_nest--;
+}
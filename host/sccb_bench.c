@@ -0,0 +1,223 @@
+/*
+ * Bit-engine microbenchmark on the simulated port.
+ *
+ * For each delay_us setting and timing profile it prints one JSON object
+ * per line, so the
+ * output can be diffed or plotted across releases:
+ *
+ *   build/sccb_bench > bench_output.txt
+ *
+ * Wire figures (line accesses, udelay, bus time) come from the simulator
+ * counters and do not depend on the host; host_ns_per_byte is the CPU time
+ * the host spent per byte and tracks the software overhead of the engine.
+ */
+
+#include <time.h>
+#include <rtthread.h>
+#include "soft_sccb_sim_port.h"
+#include "soft_sccb_table.h"
+
+#define BENCH_ADDR      SIM_SCCB_OV2640_ADDR
+#define BENCH_REGS      200
+
+struct bench_sample
+{
+    rt_uint64_t set;        /* set_sda + set_scl + set_lines */
+    rt_uint64_t get;        /* get_sda + get_scl */
+    rt_uint64_t delays;     /* udelay + ndelay calls */
+    rt_uint64_t delay_ns;
+    rt_uint64_t bytes;
+    rt_uint64_t locks;
+    rt_uint64_t bus_ns;
+    rt_uint64_t host_ns;
+};
+
+static struct sim_sccb sim;
+static struct rt_sccb_reg_entry bench_table[BENCH_REGS + 1];
+
+static rt_uint64_t host_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void bench_measure(void (*fn)(int n), int n, struct bench_sample *s)
+{
+    rt_uint32_t locks = sim.sccb_bus.stats.locks;
+    rt_uint64_t bus0 = sim.time_ns;
+    rt_uint64_t t0;
+
+    sim_sccb_stat_reset(&sim);
+    t0 = host_now_ns();
+    fn(n);
+    s->host_ns  = host_now_ns() - t0;
+    s->locks    = sim.sccb_bus.stats.locks - locks;
+    s->set      = sim.stat.set_sda + sim.stat.set_scl + sim.stat.set_lines;
+    s->get      = sim.stat.get_sda + sim.stat.get_scl;
+    s->delays   = sim.stat.udelay + sim.stat.ndelay;
+    s->delay_ns = sim.stat.delay_us * 1000 + sim.stat.delay_ns;
+    s->bytes    = sim.stat.bytes;
+    s->bus_ns   = sim.time_ns - bus0;
+}
+
+static void run_write_reg(int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        rt_sccb_write_reg(&sim.sccb_bus, BENCH_ADDR, 0x20 + i, i);
+}
+
+/* the same writes inside one bus session */
+static void run_write_reg_session(int n)
+{
+    rt_sccb_bus_lock(&sim.sccb_bus);
+    run_write_reg(n);
+    rt_sccb_bus_unlock(&sim.sccb_bus);
+}
+
+static void run_read_reg(int n)
+{
+    rt_uint8_t val;
+    int i;
+
+    for (i = 0; i < n; i++)
+        rt_sccb_read_reg(&sim.sccb_bus, BENCH_ADDR, 0x20 + i, &val);
+}
+
+static void run_write_table(int n)
+{
+    rt_sccb_write_table(&sim.sccb_bus, BENCH_ADDR, bench_table, n, RT_NULL);
+}
+
+/* one 3-phase write followed by n - 1 continuation bytes */
+static void run_write_burst(int n)
+{
+    struct rt_sccb_msg msgs[4];
+    rt_uint8_t data[4] = { 0 };
+    int i;
+
+    RT_ASSERT(n >= 1 && n <= 4);
+    for (i = 0; i < n; i++)
+    {
+        msgs[i].addr  = BENCH_ADDR;
+        msgs[i].flags = (i == 0) ? RT_SCCB_REG : RT_SCCB_NO_START;
+        msgs[i].flags |= RT_SCCB_NO_STOP;
+        msgs[i].reg   = 0x20;
+        msgs[i].len   = 1;
+        msgs[i].data  = &data[i];
+    }
+    rt_sccb_transfer(&sim.sccb_bus, msgs, n);
+}
+
+static double per(rt_uint64_t v, rt_uint64_t n)
+{
+    return n ? (double)v / n : 0.0;
+}
+
+static void report(const char *name, const char *profile, int regs,
+                   const struct bench_sample *s)
+{
+    rt_kprintf("{\"case\":\"%s\",\"profile\":\"%s\",\"regs\":%d,\"bytes\":%llu,"
+               "\"gpio_set_per_byte\":%.2f,\"gpio_get_per_byte\":%.2f,"
+               "\"delay_calls_per_byte\":%.2f,\"delay_us_per_byte\":%.3f,"
+               "\"locks_per_reg\":%.2f,\"bus_ns_per_byte\":%.1f,"
+               "\"bytes_per_sec\":%.0f,\"host_ns_per_byte\":%.1f}\n",
+               name, profile, regs, (unsigned long long)s->bytes,
+               per(s->set, s->bytes), per(s->get, s->bytes),
+               per(s->delays, s->bytes), per(s->delay_ns, s->bytes) / 1000,
+               per(s->locks, regs), per(s->bus_ns, s->bytes),
+               s->bus_ns ? s->bytes * 1e9 / s->bus_ns : 0.0,
+               per(s->host_ns, s->bytes));
+}
+
+#define DIFF(a, b, f)   ((double)(a).f - (double)(b).f)
+
+/*
+ * Split the cost of a transaction into bytes and protocol framing:
+ *   byte        = burst(2) - burst(1)
+ *   start+stop  = burst(1) - 3 bytes
+ *   read+no_ack = read_reg - 2 start/stop - 3 bytes
+ */
+static void report_protocol(const char *profile)
+{
+    struct bench_sample b1, b2, rd;
+    double byte_set, byte_delay, frame_set, frame_delay;
+
+    bench_measure(run_write_burst, 1, &b1);
+    bench_measure(run_write_burst, 2, &b2);
+    bench_measure(run_read_reg, 1, &rd);
+
+    byte_set    = DIFF(b2, b1, set);
+    byte_delay  = DIFF(b2, b1, delay_ns) / 1000;
+    frame_set   = b1.set - 3 * byte_set;
+    frame_delay = b1.delay_ns / 1000.0 - 3 * byte_delay;
+
+    rt_kprintf("{\"case\":\"protocol\",\"profile\":\"%s\","
+               "\"byte_gpio_set\":%.0f,\"byte_gpio_get\":%.0f,\"byte_delay_us\":%.3f,"
+               "\"start_stop_gpio_set\":%.0f,\"start_stop_delay_us\":%.3f,"
+               "\"read_no_ack_gpio_set\":%.0f,\"read_no_ack_delay_us\":%.3f}\n",
+               profile, byte_set, DIFF(b2, b1, get), byte_delay,
+               frame_set, frame_delay,
+               rd.set - 2 * frame_set - 3 * byte_set,
+               rd.delay_ns / 1000.0 - 2 * frame_delay - 3 * byte_delay);
+}
+
+static const struct rt_sccb_timing timing_100k = RT_SCCB_TIMING_100K;
+static const struct rt_sccb_timing timing_400k = RT_SCCB_TIMING_400K;
+
+static const struct bench_profile
+{
+    const char *name;
+    rt_uint32_t delay_us;
+    const struct rt_sccb_timing *timing;
+} profiles[] =
+{
+    { "delay_us=0",  0,  RT_NULL },
+    { "delay_us=1",  1,  RT_NULL },
+    { "delay_us=2",  2,  RT_NULL },
+    { "delay_us=5",  5,  RT_NULL },
+    { "delay_us=10", 10, RT_NULL },
+    { "timing=100k", 0,  &timing_100k },
+    { "timing=400k", 0,  &timing_400k },
+};
+
+int main(void)
+{
+    struct bench_sample s;
+    rt_size_t i;
+
+    for (i = 0; i < BENCH_REGS; i++)
+    {
+        struct rt_sccb_reg_entry e = RT_SCCB_TAB_WRITE(0x20 + i, i);
+        bench_table[i] = e;
+    }
+
+    if (sim_sccb_init(&sim, "sccb", BENCH_ADDR) != RT_EOK)
+        return 1;
+    /* settle the line shadow so the first sample is not skewed */
+    run_write_reg(1);
+
+    for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        const char *name = profiles[i].name;
+
+        sim.ops.delay_us = profiles[i].delay_us;
+        sim.ops.timing   = profiles[i].timing;
+
+        report_protocol(name);
+        bench_measure(run_write_reg, BENCH_REGS, &s);
+        report("write_reg", name, BENCH_REGS, &s);
+        bench_measure(run_write_reg_session, BENCH_REGS, &s);
+        report("write_reg_session", name, BENCH_REGS, &s);
+        bench_measure(run_read_reg, BENCH_REGS, &s);
+        report("read_reg", name, BENCH_REGS, &s);
+        bench_measure(run_write_table, BENCH_REGS, &s);
+        report("write_table", name, BENCH_REGS, &s);
+    }
+
+    return 0;
+}
@@ -0,0 +1,603 @@
+/*
+ * Simulator demo: brings up a simulated bus with a virtual OV2640,
+ * exercises the core API and prints the line access counters. Every
+ * scenario is checked against the expected registers and return codes,
+ * the first mismatch ends the run with a non-zero exit code.
+ */
+
+#include <rtthread.h>
+#include "soft_sccb_sim_port.h"
+#include "soft_sccb_table.h"
+#include "soft_sccb_async.h"
+#include "soft_sccb_cache.h"
+#include "soft_sccb_lanes.h"
+#include "soft_sccb_wave.h"
+#include "soft_sccb_dev.h"
+#include "soft_sccb_calib.h"
+#include "soft_sccb_stage.h"
+
+static struct sim_sccb sim;
+static struct rt_sccb_async async;
+static struct rt_sccb_async_req async_req[3];
+static struct rt_event async_done;
+static struct rt_sccb_regcache cache;
+static struct rt_sccb_wave wave;
+static struct rt_sccb_bus_device wave_bus;
+static struct sim_sccb irq_sim;
+static struct rt_sccb_client sensor;
+static struct rt_sccb_stage stage;
+static struct rt_semaphore stage_done;
+
+int msh_sccb(int argc, char **argv);
+
+/* a long init table from a background thread, open to preemption after the delay */
+static const struct rt_sccb_reg_entry diag_table[] =
+{
+    RT_SCCB_TAB_DELAY(10),
+    RT_SCCB_TAB_YIELD(),
+    RT_SCCB_TAB_WRITE(0x13, 0xe0),
+    RT_SCCB_TAB_WRITE(0x14, 0x48),
+    RT_SCCB_TAB_WRITE(0x10, 0x11),
+    RT_SCCB_TAB_END(),
+};
+static struct rt_semaphore diag_done;
+static struct rt_semaphore urgent_done;
+
+static void stage_committed(struct rt_sccb_stage *stage, rt_err_t result)
+{
+    rt_sem_release(&stage_done);
+}
+
+static void diag_entry(void *parameter)
+{
+    rt_sccb_write_table((struct rt_sccb_bus_device *)parameter, SIM_SCCB_OV2640_ADDR,
+                        diag_table, sizeof(diag_table) / sizeof(diag_table[0]), RT_NULL);
+    rt_sem_release(&diag_done);
+}
+
+static void urgent_entry(void *parameter)
+{
+    rt_uint8_t val;
+
+    rt_sccb_read_reg((struct rt_sccb_bus_device *)parameter, SIM_SCCB_OV2640_ADDR, 0x0a, &val);
+    rt_sem_release(&urgent_done);
+}
+
+#define DEMO_LANES      4
+
+static struct sim_sccb lane_sim[DEMO_LANES];
+static struct sim_sccb_port lane_port;
+static struct rt_sccb_lanes lanes;
+static const struct rt_sccb_lanes_ops lanes_ops =
+{
+    .data     = &lane_port,
+    .set_port = sim_sccb_port_set,
+    .get_port = sim_sccb_port_get,
+    .udelay   = sim_sccb_port_udelay,
+    .ndelay   = sim_sccb_port_ndelay,
+    .delay_us = 1,
+};
+/* the same port with a stretch deadline below the default busy-poll */
+static const struct rt_sccb_lanes_ops lanes_short_ops =
+{
+    .data       = &lane_port,
+    .set_port   = sim_sccb_port_set,
+    .get_port   = sim_sccb_port_get,
+    .udelay     = sim_sccb_port_udelay,
+    .ndelay     = sim_sccb_port_ndelay,
+    .delay_us   = 1,
+    .timeout_us = 20,
+};
+
+static const struct rt_sccb_reg_entry demo_table[] =
+{
+    RT_SCCB_TAB_WRITE(0xff, 0x01),
+    RT_SCCB_TAB_WRITE_VERIFY(0x12, 0x80),
+    RT_SCCB_TAB_MASK(0x12, 0x80, 0x00),
+    RT_SCCB_TAB_VERIFY(0x0a, 0xff, 0x26),
+    RT_SCCB_TAB_END(),
+};
+
+/* fail the run unless the scenario came out as expected */
+#define CHECK(what, cond)                                                   \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            rt_kprintf("FAIL %s: %s (line %d)\n", what, #cond, __LINE__);   \
+            return 1;                                                       \
+        }                                                                   \
+    } while (0)
+
+static void stat_dump(const char *what)
+{
+    static rt_uint64_t mark;
+
+    rt_kprintf("%-12s sda %4u scl %4u lines %4u get %4u/%-4u udelay %4u (%llu us) "
+               "bytes %u nacks %u bus %llu ns\n", what,
+               sim.stat.set_sda, sim.stat.set_scl, sim.stat.set_lines,
+               sim.stat.get_sda, sim.stat.get_scl,
+               sim.stat.udelay, (unsigned long long)sim.stat.delay_us,
+               sim.stat.bytes, sim.stat.nacks,
+               (unsigned long long)(sim.time_ns - mark));
+    sim_sccb_stat_reset(&sim);
+    mark = sim.time_ns;
+}
+
+int main(void)
+{
+    struct rt_sccb_bus_device *bus = &sim.sccb_bus;
+    rt_uint8_t pid[2];
+    rt_size_t index;
+    rt_err_t ret;
+
+    if (sim_sccb_init(&sim, "sccb", SIM_SCCB_OV2640_ADDR) != RT_EOK)
+        return 1;
+    sim_sccb_stat_reset(&sim);
+
+    ret = rt_sccb_read_reg(bus, SIM_SCCB_OV2640_ADDR, 0x0a, &pid[0]);
+    ret |= rt_sccb_read_reg(bus, SIM_SCCB_OV2640_ADDR, 0x0b, &pid[1]);
+    rt_kprintf("PID 0x%02x%02x (%d)\n", pid[0], pid[1], (int)ret);
+    CHECK("read_reg", ret == RT_EOK && pid[0] == 0x26 && pid[1] == 0x42);
+    stat_dump("read_reg x2");
+
+    ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x01);
+    rt_kprintf("CLKRC 0x%02x (%d)\n", sim.slave.regs[0x11], (int)ret);
+    CHECK("write_reg", ret == RT_EOK && sim.slave.regs[0x11] == 0x01);
+    stat_dump("write_reg");
+
+    {
+        rt_bool_t changed;
+
+        ret = rt_sccb_update_bits_check(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x3f, 0x01, &changed);
+        rt_kprintf("CLKRC field already set (%d)\n", (int)ret);
+        CHECK("update_bits", ret == RT_EOK && !changed && sim.slave.regs[0x11] == 0x01);
+    }
+    stat_dump("update_bits");
+
+    ret = rt_sccb_write_table(bus, SIM_SCCB_OV2640_ADDR, demo_table,
+                              sizeof(demo_table) / sizeof(demo_table[0]), &index);
+    rt_kprintf("table %d at entry %u\n", (int)ret, (unsigned)index);
+    CHECK("write_table", ret == RT_EOK && index == 4 && sim.slave.regs[0x12] == 0x00);
+    stat_dump("write_table");
+
+    bus->retries = 2;
+    sim.slave.nack_addr = 2;
+    ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x02);
+    rt_kprintf("NACK x2, retries %u: %d\n", (unsigned)bus->retries, (int)ret);
+    CHECK("nack", ret == RT_EOK && sim.stat.nacks == 2 && sim.slave.regs[0x11] == 0x02);
+    stat_dump("nack");
+
+    sim.slave.stretch_ns = 10000;
+    ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x03);
+    rt_kprintf("stretch %u ns x%u: %d, observed max %u us\n", sim.slave.stretch_ns,
+               sim.stat.stretches, (int)ret, sim.ops.stretch_max_us);
+    CHECK("stretch", ret == RT_EOK && sim.stat.stretches == 3 && sim.slave.regs[0x11] == 0x03);
+    stat_dump("stretch");
+
+    sim.slave.stretch_ns = 3000000;
+    ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x04);
+    rt_kprintf("stretch %u ns x%u: %d, last %u us\n", sim.slave.stretch_ns,
+               sim.stat.stretches, (int)ret, sim.ops.stretch_us);
+    CHECK("long stretch", ret == RT_EOK && sim.ops.stretch_us >= 3000 &&
+          sim.slave.regs[0x11] == 0x04);
+    stat_dump("long stretch");
+
+    /* a deadline below the busy-poll time ends the wait at the deadline */
+    {
+        rt_uint32_t timeouts = sim.ops.stretch_timeouts;
+        rt_uint64_t start = sim.time_ns;
+
+        sim.ops.timeout_us = 20;
+        ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x05);
+        sim.ops.timeout_us = 0;
+        rt_kprintf("stretch %u ns, timeout 20 us: %d after %llu us\n", sim.slave.stretch_ns,
+                   (int)ret, (unsigned long long)(sim.time_ns - start) / 1000);
+        CHECK("stretch timeout", ret == -RT_EIO && sim.ops.stretch_timeouts > timeouts &&
+              sim.time_ns - start < 100000);
+        stat_dump("timeout");
+    }
+
+    /* exposure update posted from "interrupt" context, completion by event */
+    sim.slave.stretch_ns = 0;
+    rt_event_init(&async_done, "sccb_ev", RT_IPC_FLAG_FIFO);
+    rt_sccb_async_init(&async, bus, "sccb_as", 1024, 10);
+    rt_interrupt_enter();
+    for (index = 0; index < 3; index++)
+    {
+        async_req[index].event     = &async_done;
+        async_req[index].event_set = 1u << index;
+        rt_sccb_async_write_reg(&async, &async_req[index], SIM_SCCB_OV2640_ADDR,
+                                0x10 + index, 0xa0 + index);
+    }
+    rt_interrupt_leave();
+    rt_event_recv(&async_done, 0x7, RT_EVENT_FLAG_AND | RT_EVENT_FLAG_CLEAR,
+                  RT_WAITING_FOREVER, RT_NULL);
+    rt_kprintf("async AEC 0x%02x 0x%02x 0x%02x\n", sim.slave.regs[0x10],
+               sim.slave.regs[0x11], sim.slave.regs[0x12]);
+    CHECK("async", sim.slave.regs[0x10] == 0xa0 && sim.slave.regs[0x11] == 0xa1 &&
+          sim.slave.regs[0x12] == 0xa2);
+    stat_dump("async x3");
+
+    /* shadowed sensor: repeated reads and unchanged writes stay off the bus */
+    rt_sccb_regcache_init(&cache, bus, SIM_SCCB_OV2640_ADDR);
+    rt_sccb_regcache_set_volatile(&cache, 0x00, 0x00, RT_TRUE);
+    for (index = 0; index < 4; index++)
+        ret = rt_sccb_regcache_read(&cache, 0x0a, &pid[0]);
+    ret |= rt_sccb_regcache_write(&cache, 0x11, 0x05);
+    ret |= rt_sccb_regcache_write(&cache, 0x11, 0x05);
+    rt_kprintf("cache PID 0x%02x CLKRC 0x%02x (%d)\n", pid[0],
+               sim.slave.regs[0x11], (int)ret);
+    /* one read and one write reach the device */
+    CHECK("cache", ret == RT_EOK && pid[0] == 0x26 && sim.slave.regs[0x11] == 0x05 &&
+          sim.stat.bytes == 7);
+    stat_dump("cache");
+
+    rt_sccb_regcache_cache_only(&cache, RT_TRUE);
+    for (index = 0; index < 4; index++)
+        rt_sccb_regcache_write(&cache, 0x20 + index, index);
+    rt_sccb_regcache_cache_only(&cache, RT_FALSE);
+    ret = rt_sccb_regcache_sync(&cache);
+    rt_kprintf("cache sync 0x%02x..0x%02x (%d)\n", sim.slave.regs[0x20],
+               sim.slave.regs[0x23], (int)ret);
+    CHECK("cache sync", ret == RT_EOK && sim.slave.regs[0x20] == 0x00 &&
+          sim.slave.regs[0x21] == 0x01 && sim.slave.regs[0x22] == 0x02 &&
+          sim.slave.regs[0x23] == 0x03);
+    stat_dump("cache sync");
+
+    /* the sensor's register file as a device, pos is the first register */
+    {
+        rt_uint8_t ids[0x14];
+        rt_uint8_t gains[4] = { 0x30, 0x31, 0x32, 0x33 };
+        rt_device_t dev;
+        rt_size_t n;
+
+        sensor.bus = bus;
+        sensor.client_addr = SIM_SCCB_OV2640_ADDR;
+        sensor.retries = -1;
+        rt_sccb_client_device_init(&sensor, "ov2640");
+        dev = rt_device_find("ov2640");
+        n = rt_device_write(dev, 0x20, gains, sizeof(gains));
+        n += rt_device_read(dev, 0x0a, ids, sizeof(ids));
+        rt_kprintf("window PID 0x%02x%02x MID 0x%02x%02x 0x20..0x23 0x%02x..0x%02x, %u regs\n",
+                   ids[0], ids[1], ids[0x12], ids[0x13], sim.slave.regs[0x20],
+                   sim.slave.regs[0x23], (unsigned)n);
+        CHECK("window", n == 24 && ids[0] == 0x26 && ids[1] == 0x42 && ids[0x12] == 0x7f &&
+              ids[0x13] == 0xa2 && sim.slave.regs[0x20] == 0x30 && sim.slave.regs[0x23] == 0x33);
+        stat_dump("window x24");
+    }
+
+    /* what the shell shows on target */
+    {
+        char *argv[] = { "sccb", "stats", "sccb" };
+
+        msh_sccb(3, argv);
+    }
+
+    /* the last transactions as the trace ring saw them */
+    {
+        char *argv[] = { "sccb", "trace", "sccb", "clear" };
+
+        msh_sccb(4, argv);
+        sim.slave.stretch_ns = 5000;
+        ret = rt_sccb_read_reg(bus, SIM_SCCB_OV2640_ADDR, 0x0a, &pid[0]);
+        sim.slave.stretch_ns = 0;
+        sim.slave.nack_addr = 1;
+        ret |= rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x01);
+        msh_sccb(3, argv);
+        CHECK("trace", ret == RT_EOK && pid[0] == 0x26 && sim.slave.regs[0x11] == 0x01);
+    }
+
+    /* the same sensor driven from precompiled waveforms */
+    {
+        rt_uint8_t lut[16], back[16];
+        rt_uint8_t val, n;
+
+        wave.ops = &sim.ops;
+        wave_bus.priv = &wave;
+        rt_sccb_add_wave_bus(&wave_bus, "sccbw");
+        stat_dump("trace");
+        sim.slave.stretch_ns = 5000;
+        ret = rt_sccb_write_reg(&wave_bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x06);
+        sim.slave.stretch_ns = 0;
+        ret |= rt_sccb_read_reg(&wave_bus, SIM_SCCB_OV2640_ADDR, 0x0a, &val);
+        rt_kprintf("wave PID 0x%02x CLKRC 0x%02x (%d), %u symbols, %u stretches\n",
+                   val, sim.slave.regs[0x11], (int)ret, wave.len, sim.stat.stretches);
+        CHECK("wave", ret == RT_EOK && val == 0x26 && sim.slave.regs[0x11] == 0x06 &&
+              sim.stat.stretches == 3);
+        stat_dump("wave");
+
+        ret = rt_sccb_read_burst(&wave_bus, SIM_SCCB_OV2640_ADDR, 0, 0x0a, pid, 2);
+        rt_kprintf("wave burst PID 0x%02x%02x (%d), %u symbols\n", pid[0], pid[1],
+                   (int)ret, wave.len);
+        CHECK("wave burst", ret == RT_EOK && pid[0] == 0x26 && pid[1] == 0x42);
+        stat_dump("wave burst");
+
+        /* a gamma curve is longer than one buffer, its data phases are split */
+        for (n = 0; n < sizeof(lut); n++)
+            lut[n] = 0xff - n * n;
+        ret = rt_sccb_write_burst(&wave_bus, SIM_SCCB_OV2640_ADDR, 0, 0x7c, lut, sizeof(lut));
+        ret |= rt_sccb_read_burst(&wave_bus, SIM_SCCB_OV2640_ADDR, 0, 0x7c, back, sizeof(back));
+        rt_kprintf("wave LUT 0x%02x..0x%02x, read back %s (%d)\n", sim.slave.regs[0x7c],
+                   sim.slave.regs[0x8b], rt_memcmp(lut, back, sizeof(lut)) ? "differs" : "same",
+                   (int)ret);
+        CHECK("wave x16", ret == RT_EOK && !rt_memcmp(lut, back, sizeof(lut)) &&
+              !rt_memcmp(lut, &sim.slave.regs[0x7c], sizeof(lut)));
+        stat_dump("wave x16");
+
+        /* data with no start and no device ID in front is refused */
+        {
+            struct rt_sccb_msg msg;
+
+            msg.addr  = SIM_SCCB_OV2640_ADDR;
+            msg.flags = RT_SCCB_WR | RT_SCCB_NO_START;
+            msg.reg   = 0;
+            msg.len   = 1;
+            msg.data  = lut;
+            n = rt_sccb_transfer(&wave_bus, &msg, 1);
+            CHECK("wave no start", n == 0 && sim.stat.bytes == 0);
+        }
+    }
+
+    /* a second sensor on a bus run from a (simulated) timer interrupt */
+    {
+        struct rt_sccb_bus_device *irq_bus = &irq_sim.sccb_bus;
+
+        sim_sccb_init_irq(&irq_sim, "sccbi", SIM_SCCB_OV2640_ADDR);
+        irq_bus->retries = 1;
+        irq_sim.slave.nack_addr = 1;
+        irq_sim.slave.stretch_ns = 5000;
+        ret = rt_sccb_write_reg(irq_bus, SIM_SCCB_OV2640_ADDR, 0x11, 0x07);
+        irq_sim.slave.stretch_ns = 0;
+        ret |= rt_sccb_read_reg(irq_bus, SIM_SCCB_OV2640_ADDR, 0x0b, &pid[1]);
+        rt_kprintf("irq PID 0x%02x CLKRC 0x%02x (%d), %u ticks, %u stretches, "
+                   "%u starts, bus %llu ns\n", pid[1], irq_sim.slave.regs[0x11],
+                   (int)ret, irq_sim.stat.ticks, irq_sim.stat.stretches,
+                   irq_sim.stat.starts, (unsigned long long)irq_sim.time_ns);
+        CHECK("irq", ret == RT_EOK && pid[1] == 0x42 && irq_sim.slave.regs[0x11] == 0x07 &&
+              irq_sim.stat.stretches == 3);
+        {
+            char *argv[] = { "sccb", "trace", "sccbi" };
+
+            msh_sccb(3, argv);
+        }
+    }
+
+    /* find the fastest rate the sensor takes, it needs 300 ns of data setup */
+    {
+        struct rt_sccb_timing timing;
+
+        sim.slave.setup_ns = 300;
+        rt_sccb_read_reg(bus, SIM_SCCB_OV2640_ADDR, 0x0a, &pid[0]);
+        stat_dump("read 1x");
+        ret = rt_sccb_calibrate(bus, SIM_SCCB_OV2640_ADDR, 0x20, 20, &timing);
+        rt_kprintf("calibrated (%d) high %u low %u ns\n", (int)ret,
+                   timing.scl_high_ns, timing.scl_low_ns);
+        CHECK("calibrate", ret == RT_EOK && timing.scl_high_ns >= 300 && timing.scl_low_ns >= 300);
+        stat_dump("calibrate");
+        ret = rt_sccb_read_reg(bus, SIM_SCCB_OV2640_ADDR, 0x0a, &pid[0]);
+        rt_kprintf("PID 0x%02x (%d)\n", pid[0], (int)ret);
+        CHECK("read fast", ret == RT_EOK && pid[0] == 0x26 && sim.stat.udelay == 0);
+        stat_dump("read fast");
+
+        /* a client timing profile would win over every step of the sweep */
+        {
+            static const struct rt_sccb_timing std = RT_SCCB_TIMING_400K;
+            rt_device_t dev = rt_device_find("ov2640");
+
+            rt_device_control(dev, RT_SCCB_DEV_CTRL_TIMING, (void *)&std);
+            ret = rt_sccb_calibrate(bus, SIM_SCCB_OV2640_ADDR, 0x20, 20, RT_NULL);
+            rt_device_control(dev, RT_SCCB_DEV_CTRL_TIMING, RT_NULL);
+            CHECK("calibrate client", ret == -RT_EBUSY);
+        }
+
+        /* the waveform bus keeps its rates in the ops it plays through */
+        ret = rt_sccb_calibrate(&wave_bus, SIM_SCCB_OV2640_ADDR, 0x20, 20, &timing);
+        rt_kprintf("wave calibrated (%d) high %u low %u ns\n", (int)ret,
+                   timing.scl_high_ns, timing.scl_low_ns);
+        ret |= rt_sccb_read_reg(&wave_bus, SIM_SCCB_OV2640_ADDR, 0x0a, &pid[0]);
+        CHECK("calibrate wave", ret == RT_EOK && pid[0] == 0x26 &&
+              sim.ops.rates[0].used && sim.ops.rates[0].timing.scl_high_ns == timing.scl_high_ns);
+        stat_dump("wave calib");
+    }
+
+    /* the sensor's own profile wins over the calibrated rate */
+    {
+        static const struct rt_sccb_timing std = RT_SCCB_TIMING_400K;
+        rt_device_t dev = rt_device_find("ov2640");
+
+        rt_uint64_t start = sim.time_ns;
+        rt_size_t n;
+
+        rt_device_control(dev, RT_SCCB_DEV_CTRL_TIMING, (void *)&std);
+        n = rt_device_read(dev, 0x0a, pid, 1);
+        rt_device_control(dev, RT_SCCB_DEV_CTRL_TIMING, RT_NULL);
+        rt_kprintf("profile PID 0x%02x\n", pid[0]);
+        /* 4 bytes at 400 kHz take at least 36 SCL periods of 1.9 us */
+        CHECK("read 400k", n == 1 && pid[0] == 0x26 && sim.time_ns - start >= 36 * 1900);
+        stat_dump("read 400k");
+    }
+
+    /* an exposure update with a deadline cuts into a running table */
+    {
+        rt_thread_t diag;
+        rt_uint8_t aec = 0;
+
+        rt_sccb_bus_stats_reset(bus);
+        rt_sem_init(&diag_done, "diag", 0, RT_IPC_FLAG_FIFO);
+        diag = rt_thread_create("diag", diag_entry, bus, 1024, RT_THREAD_PRIORITY_MAX - 2, 10);
+        rt_thread_startup(diag);
+        while (bus->owner != diag)
+            rt_thread_yield();
+
+        rt_sccb_bus_lock_until(bus, rt_sccb_get_us() + 1000);
+        ret = rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x10, 0x55);
+        aec = sim.slave.regs[0x10];
+        rt_sccb_bus_unlock(bus);
+        rt_sem_take(&diag_done, RT_WAITING_FOREVER);
+        rt_kprintf("deadline AEC 0x%02x (%d) inside the table, then 0x%02x, preempts %u\n",
+                   aec, (int)ret, sim.slave.regs[0x10], bus->stats.preempts);
+        CHECK("arbitrate", ret == RT_EOK && aec == 0x55 && sim.slave.regs[0x10] == 0x11 &&
+              sim.slave.regs[0x13] == 0xe0 && bus->stats.preempts == 1);
+        /* main waited on it at a higher priority, the lent one is given back */
+        CHECK("arbitrate", diag->current_priority == RT_THREAD_PRIORITY_MAX - 2);
+        stat_dump("arbitrate");
+    }
+
+    /* a more urgent waiter lends the owner its priority up to the handover */
+    {
+        rt_thread_t self = rt_thread_self();
+        rt_uint8_t prio = self->current_priority, lent;
+        rt_thread_t urgent;
+
+        rt_sem_init(&urgent_done, "urgent", 0, RT_IPC_FLAG_FIFO);
+        rt_sccb_bus_lock(bus);
+        urgent = rt_thread_create("urgent", urgent_entry, bus, 1024, prio - 8, 10);
+        rt_thread_startup(urgent);
+        while (rt_list_isempty(&bus->waiters))
+            rt_thread_yield();
+        lent = self->current_priority;
+        rt_sccb_bus_unlock(bus);
+        rt_sem_take(&urgent_done, RT_WAITING_FOREVER);
+        rt_kprintf("priority %u, lent %u while owning, %u after unlock\n", prio, lent,
+                   self->current_priority);
+        CHECK("lend", lent == prio - 8 && self->current_priority == prio &&
+              urgent->current_priority == prio - 8 && bus->owner == RT_NULL);
+        stat_dump("lend");
+    }
+
+    /* exposure, gain and AEC window staged over a frame, sent at VSYNC */
+    {
+        rt_uint8_t i;
+
+        rt_sccb_stage_init(&stage, bus, 500);
+        stage.done = stage_committed;
+        rt_sem_init(&stage_done, "stage", 0, RT_IPC_FLAG_FIFO);
+        rt_sccb_stage_start(&stage, "sccb_st", 1024, 5);
+        for (i = 0; i < 4; i++)
+        {
+            rt_sccb_stage_write(&stage, SIM_SCCB_OV2640_ADDR, 0x10, 0x20 + i);
+            rt_sccb_stage_write(&stage, SIM_SCCB_OV2640_ADDR, 0x00, 0x08 + i);
+        }
+        rt_sccb_stage_write(&stage, SIM_SCCB_OV2640_ADDR, 0x24, 0x40);
+        rt_sccb_stage_write(&stage, SIM_SCCB_OV2640_ADDR, 0x25, 0x38);
+        rt_kprintf("staged, AEC still 0x%02x\n", sim.slave.regs[0x10]);
+        CHECK("stage", sim.slave.regs[0x10] == 0x11);
+
+        rt_interrupt_enter();
+        rt_sccb_stage_trigger(&stage);
+        rt_interrupt_leave();
+        rt_sem_take(&stage_done, RT_WAITING_FOREVER);
+        rt_kprintf("vsync AEC 0x%02x gain 0x%02x window 0x%02x/0x%02x, "
+                   "%u regs in %u commit, %u merged\n", sim.slave.regs[0x10],
+                   sim.slave.regs[0x00], sim.slave.regs[0x24], sim.slave.regs[0x25],
+                   stage.writes, stage.commits, stage.merges);
+        CHECK("stage", sim.slave.regs[0x10] == 0x23 && sim.slave.regs[0x00] == 0x0b &&
+              sim.slave.regs[0x24] == 0x40 && sim.slave.regs[0x25] == 0x38 &&
+              stage.writes == 4 && stage.commits == 1 && stage.merges == 6);
+        stat_dump("stage");
+    }
+
+    /* soft reset, then poll COM7 until the reset bit clears */
+    {
+        rt_uint32_t elapsed, xfers;
+
+        sim.slave.reset_ns = 3000000;
+        rt_sccb_write_reg(bus, SIM_SCCB_OV2640_ADDR, 0x12, 0x80);
+        xfers = bus->stats.xfers;
+        ret = rt_sccb_wait_reg(bus, SIM_SCCB_OV2640_ADDR, 0x12, 0x80, 0x00, 100000, &elapsed);
+        rt_kprintf("reset done (%d) after %u us, %u polls\n", (int)ret,
+                   elapsed, bus->stats.xfers - xfers);
+        CHECK("wait_reg", ret == RT_EOK && elapsed >= 3000 && !(sim.slave.regs[0x12] & 0x80));
+        sim.slave.reset_ns = 0;
+        stat_dump("wait_reg");
+    }
+
+    /* a gamma curve as one sequential write, read back in one burst */
+    {
+        rt_uint8_t lut[16], back[16];
+        rt_uint8_t n;
+
+        for (n = 0; n < sizeof(lut); n++)
+            lut[n] = 0x04 + n * n;
+        ret = rt_sccb_write_burst(bus, SIM_SCCB_OV2640_ADDR, 0, 0x7c, lut, sizeof(lut));
+        ret |= rt_sccb_read_burst(bus, SIM_SCCB_OV2640_ADDR, 0, 0x7c, back, sizeof(back));
+        rt_kprintf("burst LUT 0x%02x..0x%02x, read back %s (%d)\n", sim.slave.regs[0x7c],
+                   sim.slave.regs[0x8b], rt_memcmp(lut, back, sizeof(lut)) ? "differs" : "same",
+                   (int)ret);
+        CHECK("burst x16", ret == RT_EOK && !rt_memcmp(lut, back, sizeof(lut)) &&
+              !rt_memcmp(lut, &sim.slave.regs[0x7c], sizeof(lut)));
+        stat_dump("burst x16");
+
+        /* 16-bit sub-addresses, as on the OV5640 class of sensors */
+        irq_sim.slave.reg16 = 1;
+        ret = rt_sccb_write_burst(&irq_sim.sccb_bus, SIM_SCCB_OV2640_ADDR, RT_SCCB_REG16,
+                                  0x3820, lut, 2);
+        ret |= rt_sccb_read_burst(&irq_sim.sccb_bus, SIM_SCCB_OV2640_ADDR, RT_SCCB_REG16,
+                                  0x3820, back, 2);
+        rt_kprintf("reg16 0x3820/1 0x%02x 0x%02x (%d)\n", back[0], back[1], (int)ret);
+        CHECK("reg16", ret == RT_EOK && back[0] == lut[0] && back[1] == lut[1]);
+        irq_sim.slave.reg16 = 0;
+    }
+
+    /* four identical sensors clocked in lockstep from one port */
+    for (index = 0; index < DEMO_LANES; index++)
+    {
+        char name[RT_NAME_MAX];
+
+        rt_snprintf(name, sizeof(name), "lane%u", (unsigned)index);
+        sim_sccb_init(&lane_sim[index], name, SIM_SCCB_OV2640_ADDR);
+        lane_port.lane[index] = &lane_sim[index];
+        lanes.sda[index] = 1u << index;
+    }
+    lane_port.num = DEMO_LANES;
+    lanes.ops = &lanes_ops;
+    lanes.scl = SIM_SCCB_PORT_SCL;
+    lanes.num = DEMO_LANES;
+    rt_sccb_lanes_init(&lanes, "lanes");
+
+    {
+        rt_uint8_t vals[DEMO_LANES] = { 0x10, 0x20, 0x30, 0x40 };
+        rt_uint32_t ok;
+
+        lane_port.set_port = lane_port.get_port = 0;
+        ok = rt_sccb_lanes_write_reg_all(&lanes, RT_SCCB_LANES_ALL,
+                                         SIM_SCCB_OV2640_ADDR, 0x11, 0x01);
+        ok &= rt_sccb_lanes_write_reg(&lanes, RT_SCCB_LANES_ALL,
+                                      SIM_SCCB_OV2640_ADDR, 0x10, vals);
+        ok &= rt_sccb_lanes_read_reg(&lanes, RT_SCCB_LANES_ALL,
+                                     SIM_SCCB_OV2640_ADDR, 0x0a, vals);
+        rt_kprintf("lanes ok 0x%x PID 0x%02x 0x%02x 0x%02x 0x%02x AEC 0x%02x..0x%02x\n",
+                   ok, vals[0], vals[1], vals[2], vals[3],
+                   lane_sim[0].slave.regs[0x10], lane_sim[3].slave.regs[0x10]);
+        rt_kprintf("%-12s port set %4u get %4u for %d lanes, bus %llu ns\n", "lanes x3",
+                   lane_port.set_port, lane_port.get_port, DEMO_LANES,
+                   (unsigned long long)lane_port.time_ns);
+        CHECK("lanes", ok == 0xf);
+        for (index = 0; index < DEMO_LANES; index++)
+            CHECK("lanes", vals[index] == 0x26 && lane_sim[index].slave.regs[0x11] == 0x01 &&
+                  lane_sim[index].slave.regs[0x10] == 0x10 * (index + 1));
+    }
+
+    /* one lane stretching past ops->timeout_us aborts the lockstep transfer */
+    {
+        rt_uint64_t start = lane_port.time_ns;
+        rt_uint32_t ok;
+
+        lanes.ops = &lanes_short_ops;
+        lane_sim[2].slave.stretch_ns = 3000000;
+        ok = rt_sccb_lanes_write_reg_all(&lanes, RT_SCCB_LANES_ALL,
+                                         SIM_SCCB_OV2640_ADDR, 0x11, 0x02);
+        lane_sim[2].slave.stretch_ns = 0;
+        lanes.ops = &lanes_ops;
+        rt_kprintf("lanes stretch timeout ok 0x%x after %llu us, %u timeouts\n", ok,
+                   (unsigned long long)(lane_port.time_ns - start) / 1000,
+                   lanes.stretch_timeouts);
+        CHECK("lanes timeout", ok == 0 && lanes.stretch_timeouts > 0 &&
+              lane_port.time_ns - start < 1000000);
+    }
+
+    rt_kprintf("all scenarios passed\n");
+
+    return 0;
+}
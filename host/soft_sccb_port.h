@@ -0,0 +1,52 @@
+/*
+ * Inline port for RT_SCCB_USING_INLINE_PORT on the host: the bit engine
+ * calls the simulator line routines directly instead of through
+ * rt_sccb_ops. Build with 'make INLINE=1'.
+ */
+
+#ifndef __SOFT_SCCB_PORT_H__
+#define __SOFT_SCCB_PORT_H__
+
+#include <rtthread.h>
+#include "soft_sccb_sim_port.h"
+
+rt_inline void sccb_port_set_sda(void *data, rt_int32_t state)
+{
+    sim_sccb_set_sda(data, state);
+}
+
+rt_inline void sccb_port_set_scl(void *data, rt_int32_t state)
+{
+    sim_sccb_set_scl(data, state);
+}
+
+rt_inline rt_int32_t sccb_port_get_sda(void *data)
+{
+    return sim_sccb_get_sda(data);
+}
+
+rt_inline rt_int32_t sccb_port_get_scl(void *data)
+{
+    return sim_sccb_get_scl(data);
+}
+
+#define SCCB_PORT_HAS_SET_LINES
+
+rt_inline void sccb_port_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    sim_sccb_set_lines(data, mask, values);
+}
+
+rt_inline void sccb_port_udelay(rt_uint32_t us)
+{
+    sim_sccb_udelay(us);
+}
+
+#define SCCB_PORT_HAS_NDELAY
+
+rt_inline void sccb_port_ndelay(rt_uint32_t ns)
+{
+    sim_sccb_ndelay(ns);
+}
+
+#endif
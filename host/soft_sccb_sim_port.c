@@ -0,0 +1,516 @@
+/*
+ * Simulated soft_sccb port for Linux hosts.
+ *
+ * Both lines are open-drain: a line is high only when neither the master
+ * nor the slave pulls it low. Every access through rt_sccb_ops costs
+ * gpio_ns of virtual time and udelay() advances the clock by its argument,
+ * so the clock reflects bus time rather than host run time.
+ */
+
+#include <rtthread.h>
+#include "soft_sccb_sim_port.h"
+
+#define DBG_TAG               "SCCB.sim"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+enum
+{
+    SIM_STATE_IDLE = 0,
+    SIM_STATE_ADDR,
+    SIM_STATE_WRITE,
+    SIM_STATE_READ,
+};
+
+#define SIM_REG_COM7            0x12
+#define SIM_COM7_SRST           0x80
+
+/* udelay()/ndelay() carry no context, they are charged to the last bus touched */
+static __thread struct sim_sccb *sim_active;
+
+/* OV2640 identification registers, everything else resets to 0 */
+static void slave_regs_default(struct sim_sccb_slave *slave)
+{
+    rt_memset(slave->regs, 0, sizeof(slave->regs));
+    slave->regs[0x0a] = 0x26;   /* PIDH */
+    slave->regs[0x0b] = 0x42;   /* PIDL */
+    slave->regs[0x1c] = 0x7f;   /* MIDH */
+    slave->regs[0x1d] = 0xa2;   /* MIDL */
+}
+
+static void slave_start(struct sim_sccb *sim)
+{
+    struct sim_sccb_slave *slave = &sim->slave;
+
+    slave->state   = SIM_STATE_ADDR;
+    slave->bits    = 0;
+    slave->shift   = 0;
+    slave->index   = 0;
+    slave->sda_out = 1;
+    sim->stat.starts++;
+}
+
+static void slave_stop(struct sim_sccb *sim)
+{
+    sim->slave.state   = SIM_STATE_IDLE;
+    sim->slave.sda_out = 1;
+    sim->stat.stops++;
+}
+
+/* a whole byte was clocked in, decide whether to acknowledge it */
+static void slave_byte_in(struct sim_sccb *sim)
+{
+    struct sim_sccb_slave *slave = &sim->slave;
+    rt_uint8_t byte = slave->shift;
+
+    slave->ack = 1;
+    if (slave->state == SIM_STATE_ADDR)
+    {
+        if ((byte >> 1) != slave->addr)
+        {
+            slave->ack = 0;
+        }
+        else if (slave->nack_addr)
+        {
+            slave->nack_addr--;
+            slave->ack = 0;
+        }
+    }
+    else if (slave->index < 32 && (slave->nack_mask & (1u << slave->index)))
+    {
+        slave->ack = 0;
+    }
+    else if (slave->index == 1 || (slave->reg16 && slave->index == 2))
+    {
+        slave->ptr = byte;
+    }
+    else
+    {
+        if (slave->ptr == SIM_REG_COM7 && (byte & SIM_COM7_SRST))
+            slave->reset_end = sim->time_ns + slave->reset_ns;
+        slave->regs[slave->ptr++] = byte;
+    }
+
+    slave->index++;
+    sim->stat.bytes++;
+    if (!slave->ack)
+        sim->stat.nacks++;
+}
+
+/* the SDA level the slave latches at a rising SCL edge */
+static rt_uint8_t slave_sda(struct sim_sccb *sim)
+{
+    if (sim->time_ns - sim->sda_ns < sim->slave.setup_ns)
+        return sim->sda_prev;
+
+    return sim->sda;
+}
+
+static void slave_scl_rise(struct sim_sccb *sim)
+{
+    struct sim_sccb_slave *slave = &sim->slave;
+
+    if (slave->state == SIM_STATE_IDLE)
+        return;
+
+    if (slave->bits < 8)
+    {
+        slave->bits++;
+        if (slave->state == SIM_STATE_READ)
+            return;
+        slave->shift = (slave->shift << 1) | slave_sda(sim);
+        if (slave->bits == 8)
+            slave_byte_in(sim);
+    }
+    else if (slave->bits == 8)
+    {
+        slave->bits = 9;
+        if (slave->state == SIM_STATE_READ)
+        {
+            /* master ACK keeps the burst going */
+            slave->ack = !slave_sda(sim);
+            sim->stat.bytes++;
+        }
+    }
+}
+
+static void slave_scl_fall(struct sim_sccb *sim)
+{
+    struct sim_sccb_slave *slave = &sim->slave;
+
+    if (slave->state == SIM_STATE_IDLE)
+        return;
+
+    if (slave->bits == 8)
+    {
+        /* ACK phase, the receiver drives SDA */
+        slave->sda_out = (slave->state == SIM_STATE_READ) ? 1 : !slave->ack;
+        return;
+    }
+    if (slave->bits < 8)
+    {
+        if (slave->state == SIM_STATE_READ && slave->bits > 0)
+            slave->sda_out = (slave->shift >> (7 - slave->bits)) & 1;
+        return;
+    }
+
+    /* ACK phase done, set up the next byte */
+    slave->bits    = 0;
+    slave->sda_out = 1;
+    if (!slave->ack)
+    {
+        slave->state = SIM_STATE_IDLE;
+        return;
+    }
+    if (slave->state == SIM_STATE_ADDR)
+        slave->state = (slave->shift & 1) ? SIM_STATE_READ : SIM_STATE_WRITE;
+    if (slave->state == SIM_STATE_READ)
+    {
+        /* a soft reset with reset_ns set clears itself, like the sensor's */
+        if (slave->reset_ns && sim->time_ns >= slave->reset_end)
+            slave->regs[SIM_REG_COM7] &= ~SIM_COM7_SRST;
+        slave->shift   = slave->regs[slave->ptr++];
+        slave->sda_out = slave->shift >> 7;
+    }
+
+    if (slave->stretch_ns)
+    {
+        slave->scl_hold = sim->time_ns + slave->stretch_ns;
+        sim->stat.stretches++;
+        sim->stat.stretch_ns += slave->stretch_ns;
+    }
+}
+
+/* resolve the wired-AND levels and feed any edge to the slave */
+static void sim_resolve(struct sim_sccb *sim)
+{
+    rt_uint8_t scl, sda;
+
+    scl = sim->scl_drv && sim->time_ns >= sim->slave.scl_hold;
+    if (scl != sim->scl)
+    {
+        sim->scl = scl;
+        if (scl)
+            slave_scl_rise(sim);
+        else
+            slave_scl_fall(sim);
+    }
+
+    sda = sim->sda_drv && sim->slave.sda_out;
+    if (sda != sim->sda)
+    {
+        sim->sda_prev = sim->sda;
+        sim->sda_ns   = sim->time_ns;
+        sim->sda = sda;
+        if (sim->scl)
+        {
+            if (sda)
+                slave_stop(sim);
+            else
+                slave_start(sim);
+        }
+    }
+}
+
+rt_inline struct sim_sccb *sim_access(void *data)
+{
+    struct sim_sccb *sim = (struct sim_sccb *)data;
+
+    sim_active = sim;
+    sim->time_ns += sim->gpio_ns;
+
+    return sim;
+}
+
+void sim_sccb_set_sda(void *data, rt_int32_t state)
+{
+    struct sim_sccb *sim = sim_access(data);
+
+    sim->stat.set_sda++;
+    sim->sda_drv = state ? 1 : 0;
+    sim_resolve(sim);
+}
+
+void sim_sccb_set_scl(void *data, rt_int32_t state)
+{
+    struct sim_sccb *sim = sim_access(data);
+
+    sim->stat.set_scl++;
+    sim->scl_drv = state ? 1 : 0;
+    sim_resolve(sim);
+}
+
+void sim_sccb_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    struct sim_sccb *sim = sim_access(data);
+
+    sim->stat.set_lines++;
+    if (mask & RT_SCCB_LINE_SDA)
+        sim->sda_drv = (values & RT_SCCB_LINE_SDA) ? 1 : 0;
+    if (mask & RT_SCCB_LINE_SCL)
+        sim->scl_drv = (values & RT_SCCB_LINE_SCL) ? 1 : 0;
+    sim_resolve(sim);
+}
+
+rt_int32_t sim_sccb_get_sda(void *data)
+{
+    struct sim_sccb *sim = sim_access(data);
+
+    sim->stat.get_sda++;
+    sim_resolve(sim);
+
+    return sim->sda;
+}
+
+rt_int32_t sim_sccb_get_scl(void *data)
+{
+    struct sim_sccb *sim = sim_access(data);
+
+    sim->stat.get_scl++;
+    sim_resolve(sim);
+
+    return sim->scl;
+}
+
+void sim_sccb_udelay(rt_uint32_t us)
+{
+    struct sim_sccb *sim = sim_active;
+
+    if (sim == RT_NULL)
+        return;
+
+    sim->stat.udelay++;
+    sim->stat.delay_us += us;
+    sim->time_ns += (rt_uint64_t)us * 1000;
+    sim_resolve(sim);
+}
+
+void sim_sccb_ndelay(rt_uint32_t ns)
+{
+    struct sim_sccb *sim = sim_active;
+
+    if (sim == RT_NULL)
+        return;
+
+    sim->stat.ndelay++;
+    sim->stat.delay_ns += ns;
+    sim->time_ns += ns;
+    sim_resolve(sim);
+}
+
+/* thread sleeps inside the core, e.g. a clock-stretch wait, pass bus time */
+static void sim_thread_delay(rt_tick_t tick)
+{
+    struct sim_sccb *sim = sim_active;
+
+    if (sim == RT_NULL)
+        return;
+
+    sim->time_ns += (rt_uint64_t)tick * (1000000000ull / RT_TICK_PER_SECOND);
+    sim_resolve(sim);
+}
+
+/* bus statistics run on the virtual clock of the last bus touched */
+rt_uint32_t rt_sccb_get_us(void)
+{
+    struct sim_sccb *sim = sim_active;
+
+    return sim ? (rt_uint32_t)(sim->time_ns / 1000) : 0;
+}
+
+/* port delays carry no context either, they are charged to the last port touched */
+static __thread struct sim_sccb_port *port_active;
+
+/* one port access, every lane sees the same time pass */
+static void port_advance(struct sim_sccb_port *port, rt_uint64_t ns)
+{
+    rt_uint32_t i;
+
+    port_active = port;
+    port->time_ns += ns;
+    for (i = 0; i < port->num; i++)
+    {
+        port->lane[i]->time_ns += ns;
+        sim_resolve(port->lane[i]);
+    }
+}
+
+void sim_sccb_port_set(void *data, rt_uint32_t mask, rt_uint32_t values)
+{
+    struct sim_sccb_port *port = (struct sim_sccb_port *)data;
+    struct sim_sccb *sim;
+    rt_uint32_t i;
+
+    port->set_port++;
+    for (i = 0; i < port->num; i++)
+    {
+        /* SCL first on every lane, then SDA, as one write would resolve */
+        sim = port->lane[i];
+        if (mask & SIM_SCCB_PORT_SCL)
+        {
+            sim->scl_drv = (values & SIM_SCCB_PORT_SCL) ? 1 : 0;
+            if (!sim->scl_drv)
+                sim_resolve(sim);
+        }
+        if (mask & (1u << i))
+            sim->sda_drv = (values & (1u << i)) ? 1 : 0;
+    }
+    port_advance(port, port->lane[0]->gpio_ns);
+}
+
+rt_uint32_t sim_sccb_port_get(void *data)
+{
+    struct sim_sccb_port *port = (struct sim_sccb_port *)data;
+    rt_uint32_t i, values = SIM_SCCB_PORT_SCL;
+
+    port->get_port++;
+    port_advance(port, port->lane[0]->gpio_ns);
+    for (i = 0; i < port->num; i++)
+    {
+        if (port->lane[i]->sda)
+            values |= 1u << i;
+        if (!port->lane[i]->scl)
+            values &= ~SIM_SCCB_PORT_SCL;
+    }
+
+    return values;
+}
+
+void sim_sccb_port_udelay(rt_uint32_t us)
+{
+    if (port_active)
+        port_advance(port_active, (rt_uint64_t)us * 1000);
+}
+
+void sim_sccb_port_ndelay(rt_uint32_t ns)
+{
+    if (port_active)
+        port_advance(port_active, ns);
+}
+
+static const struct rt_sccb_ops sim_bit_ops_default =
+{
+    .data     = RT_NULL,
+    .set_sda  = sim_sccb_set_sda,
+    .set_scl  = sim_sccb_set_scl,
+    .get_sda  = sim_sccb_get_sda,
+    .get_scl  = sim_sccb_get_scl,
+    .set_lines = sim_sccb_set_lines,
+    .udelay   = sim_sccb_udelay,
+    .ndelay   = sim_sccb_ndelay,
+    .delay_us = 1,
+    .timeout  = 100
+};
+
+/**
+ * This function restores the slave registers to their reset values and
+ * releases the lines. Stretch and NACK settings are kept.
+ *
+ * @param sim the simulated bus.
+ */
+void sim_sccb_slave_reset(struct sim_sccb *sim)
+{
+    slave_regs_default(&sim->slave);
+    sim->slave.state    = SIM_STATE_IDLE;
+    sim->slave.bits     = 0;
+    sim->slave.ptr      = 0;
+    sim->slave.sda_out  = 1;
+    sim->slave.scl_hold = 0;
+    sim_resolve(sim);
+}
+
+/**
+ * This function clears the access counters, the virtual clock keeps running.
+ *
+ * @param sim the simulated bus.
+ */
+void sim_sccb_stat_reset(struct sim_sccb *sim)
+{
+    rt_memset(&sim->stat, 0, sizeof(sim->stat));
+}
+
+/* a released bus with one virtual slave, not registered yet */
+static void sim_sccb_setup(struct sim_sccb *sim, rt_uint8_t addr)
+{
+    rt_memset(sim, 0, sizeof(*sim));
+    sim->ops         = sim_bit_ops_default;
+    sim->ops.data    = sim;
+    sim->gpio_ns     = SIM_SCCB_GPIO_NS;
+    sim->sda_drv     = sim->scl_drv = 1;
+    sim->sda         = sim->scl     = 1;
+    sim->sda_prev    = 1;
+    sim->slave.addr  = addr;
+    sim_sccb_slave_reset(sim);
+
+    rt_host_delay_sethook(sim_thread_delay);
+
+    sim->sccb_bus.priv = &sim->ops;
+}
+
+/**
+ * This function sets up a simulated bus with one virtual slave and
+ * registers it as an SCCB bus device.
+ *
+ * @param sim the simulated bus.
+ * @param bus_name the bus device name.
+ * @param addr the 7-bit address of the virtual slave.
+ *
+ * @return the error code, RT_EOK on successfully.
+ */
+rt_err_t sim_sccb_init(struct sim_sccb *sim, const char *bus_name, rt_uint8_t addr)
+{
+    RT_ASSERT(sim != RT_NULL);
+
+    sim_sccb_setup(sim, addr);
+
+    return rt_sccb_add_bus(&sim->sccb_bus, bus_name);
+}
+
+/* the simulated bus timer fires in the caller's context until the engine stops it */
+static rt_err_t sim_timer_start(void *data, rt_uint32_t period_ns)
+{
+    struct sim_sccb *sim = (struct sim_sccb *)data;
+
+    sim->timer_on = 1;
+    while (sim->timer_on)
+    {
+        sim_active = sim;
+        sim->time_ns += period_ns ? period_ns : sim->gpio_ns;
+        sim_resolve(sim);
+        sim->stat.ticks++;
+        rt_sccb_fsm_tick(&sim->ops);
+    }
+
+    return RT_EOK;
+}
+
+static void sim_timer_stop(void *data)
+{
+    ((struct sim_sccb *)data)->timer_on = 0;
+}
+
+/**
+ * This function sets up a simulated bus like sim_sccb_init(), but with a
+ * simulated bus timer, so it runs the interrupt-driven engine.
+ *
+ * @param sim the simulated bus.
+ * @param bus_name the bus device name.
+ * @param addr the 7-bit address of the virtual slave.
+ *
+ * @return the error code, RT_EOK on successfully.
+ */
+rt_err_t sim_sccb_init_irq(struct sim_sccb *sim, const char *bus_name, rt_uint8_t addr)
+{
+    RT_ASSERT(sim != RT_NULL);
+
+    sim_sccb_setup(sim, addr);
+    sim->ops.timer_start = sim_timer_start;
+    sim->ops.timer_stop  = sim_timer_stop;
+    sim->ops.fsm         = &sim->fsm;
+
+    return rt_sccb_add_bus(&sim->sccb_bus, bus_name);
+}
@@ -0,0 +1,130 @@
+/*
+ * Simulated soft_sccb port for Linux hosts. The rt_sccb_ops line routines
+ * drive an open-drain SDA/SCL model that counts every access and keeps a
+ * virtual clock; a virtual OmniVision-style SCCB slave sits on the lines.
+ */
+
+#ifndef __SOFT_SCCB_SIM_PORT_H__
+#define __SOFT_SCCB_SIM_PORT_H__
+
+#include <rtthread.h>
+#include "soft_sccb.h"
+#include "soft_sccb_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_SCCB_OV2640_ADDR     0x30    /* 7-bit, 0x60/0x61 on the wire */
+#define SIM_SCCB_GPIO_NS         20      /* default cost of one line access */
+
+/* line access and protocol counters */
+struct sim_sccb_stat
+{
+    rt_uint32_t set_sda;
+    rt_uint32_t set_scl;
+    rt_uint32_t get_sda;
+    rt_uint32_t get_scl;
+    rt_uint32_t set_lines;
+    rt_uint32_t udelay;
+    rt_uint64_t delay_us;       /* sum of all udelay arguments */
+    rt_uint32_t ndelay;
+    rt_uint64_t delay_ns;       /* sum of all ndelay arguments */
+
+    rt_uint32_t starts;
+    rt_uint32_t stops;
+    rt_uint32_t bytes;          /* bytes seen by the slave, address included */
+    rt_uint32_t nacks;          /* bytes the slave did not acknowledge */
+    rt_uint32_t stretches;
+    rt_uint64_t stretch_ns;     /* total time the slave held SCL low */
+    rt_uint32_t ticks;          /* bus timer ticks of the interrupt-driven engine */
+};
+
+/* virtual slave, 256 8-bit registers with auto-increment */
+struct sim_sccb_slave
+{
+    rt_uint8_t  addr;           /* 7-bit address */
+    rt_uint8_t  regs[256];
+
+    rt_uint32_t stretch_ns;     /* hold SCL low this long after each ACK */
+    rt_uint32_t nack_addr;      /* NACK the next n matching address bytes */
+    rt_uint32_t nack_mask;      /* NACK byte n of a write when bit n is set */
+    rt_uint32_t setup_ns;       /* SDA settles this long before SCL rises, or the
+                                   old level is sampled */
+    rt_uint32_t reset_ns;       /* COM7 soft reset bit stays set this long */
+    rt_uint64_t reset_end;
+    rt_uint8_t  reg16;          /* two sub-address bytes, high first, the low one
+                                   picks the register */
+
+    /* decoder state */
+    rt_uint8_t  state;
+    rt_uint8_t  bits;
+    rt_uint8_t  shift;
+    rt_uint8_t  ack;
+    rt_uint8_t  ptr;
+    rt_uint8_t  index;          /* byte index within the transaction */
+    rt_uint8_t  sda_out;        /* 0 while pulling SDA low */
+    rt_uint64_t scl_hold;       /* SCL is pulled low until this time */
+};
+
+struct sim_sccb
+{
+    struct rt_sccb_ops          ops;
+    struct rt_sccb_bus_device   sccb_bus;
+    struct sim_sccb_slave       slave;
+    struct sim_sccb_stat        stat;
+    struct rt_sccb_fsm          fsm;
+    rt_uint8_t                  timer_on;
+
+    rt_uint64_t time_ns;        /* virtual clock, never rewind it */
+    rt_uint32_t gpio_ns;        /* cost of one line access */
+    rt_uint8_t  sda_drv;        /* master output latches, 1 = released */
+    rt_uint8_t  scl_drv;
+    rt_uint8_t  sda;            /* resolved wired-AND levels */
+    rt_uint8_t  scl;
+    rt_uint8_t  sda_prev;       /* SDA level before its last change */
+    rt_uint64_t sda_ns;         /* time of the last SDA change */
+};
+
+/*
+ * several simulated buses wired to one virtual GPIO port for the multi-lane
+ * engine: lane n SDA is port bit n, SCL is SIM_SCCB_PORT_SCL on every lane.
+ */
+#define SIM_SCCB_PORT_LANES      8
+#define SIM_SCCB_PORT_SCL        (1u << 31)
+
+struct sim_sccb_port
+{
+    struct sim_sccb *lane[SIM_SCCB_PORT_LANES];
+    rt_uint32_t num;
+
+    rt_uint32_t set_port;       /* port writes */
+    rt_uint32_t get_port;       /* port reads */
+    rt_uint64_t time_ns;        /* virtual clock of the port */
+};
+
+rt_err_t sim_sccb_init(struct sim_sccb *sim, const char *bus_name, rt_uint8_t addr);
+rt_err_t sim_sccb_init_irq(struct sim_sccb *sim, const char *bus_name, rt_uint8_t addr);
+void sim_sccb_slave_reset(struct sim_sccb *sim);
+void sim_sccb_stat_reset(struct sim_sccb *sim);
+
+/* line routines, for rt_sccb_ops or the inline port */
+void sim_sccb_set_sda(void *data, rt_int32_t state);
+void sim_sccb_set_scl(void *data, rt_int32_t state);
+rt_int32_t sim_sccb_get_sda(void *data);
+rt_int32_t sim_sccb_get_scl(void *data);
+void sim_sccb_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values);
+void sim_sccb_udelay(rt_uint32_t us);
+void sim_sccb_ndelay(rt_uint32_t ns);
+
+/* port routines, for rt_sccb_lanes_ops */
+void sim_sccb_port_set(void *data, rt_uint32_t mask, rt_uint32_t values);
+rt_uint32_t sim_sccb_port_get(void *data);
+void sim_sccb_port_udelay(rt_uint32_t us);
+void sim_sccb_port_ndelay(rt_uint32_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
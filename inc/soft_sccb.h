@@ -17,6 +17,74 @@ extern "C" {
 
 #include "soft_sccb_core.h"
 
+/*
+ * With RT_SCCB_USING_INLINE_PORT the bit engine does not call through
+ * rt_sccb_ops for line access. The port header named by RT_SCCB_PORT_HEADER
+ * provides these as static inline functions instead:
+ *
+ *   void       sccb_port_set_sda(void *data, rt_int32_t state);
+ *   void       sccb_port_set_scl(void *data, rt_int32_t state);
+ *   rt_int32_t sccb_port_get_sda(void *data);
+ *   rt_int32_t sccb_port_get_scl(void *data);
+ *   void       sccb_port_udelay(rt_uint32_t us);
+ *
+ * and optionally, each announced by defining SCCB_PORT_HAS_SET_LINES or
+ * SCCB_PORT_HAS_NDELAY:
+ *
+ *   void       sccb_port_set_lines(void *data, rt_uint32_t mask, rt_uint32_t values);
+ *   void       sccb_port_ndelay(rt_uint32_t ns);
+ *
+ * data is still taken from rt_sccb_ops, as are delay_us, timeout and timing.
+ */
+#if defined(RT_SCCB_USING_INLINE_PORT) && !defined(RT_SCCB_PORT_HEADER)
+#define RT_SCCB_PORT_HEADER     "soft_sccb_port.h"
+#endif
+
+#ifndef RT_SCCB_STRETCH_SPIN_US
+#define RT_SCCB_STRETCH_SPIN_US 50      /* default busy-poll before yielding */
+#endif
+
+#ifndef RT_SCCB_RATES
+#define RT_SCCB_RATES           4       /* devices with a calibrated timing per bus */
+#endif
+
+#define RT_SCCB_LINE_SDA        (1u << 0)
+#define RT_SCCB_LINE_SCL        (1u << 1)
+
+/* the timing of one device, see rt_sccb_calibrate() */
+struct rt_sccb_rate
+{
+    rt_uint16_t addr;
+    rt_uint8_t  used;
+    struct rt_sccb_timing timing;
+};
+
+/*
+ * state of the interrupt-driven engine. rt_sccb_fsm_tick() advances it by
+ * one bus phase per call, from a periodic timer the port starts and stops
+ * through the timer hooks of rt_sccb_ops.
+ */
+struct rt_sccb_fsm
+{
+    struct rt_sccb_bus_device *bus;
+    struct rt_sccb_msg *msgs;
+    rt_uint32_t num;
+    rt_uint32_t index;       /* current message, messages done at the end */
+    rt_uint32_t stall;       /* ticks SCL has been held low by a slave */
+    rt_uint32_t stall_max;
+    rt_uint8_t  state;
+    rt_uint8_t  step;        /* message phase: device ID, sub-address, data */
+    rt_uint16_t pos;         /* data bytes of the current message done */
+    rt_uint8_t  then;        /* what follows the current stop */
+    rt_uint8_t  shift;       /* byte being clocked */
+    rt_uint8_t  bit;         /* bits clocked, the 9th is the ACK */
+    rt_uint8_t  rx;
+    rt_uint8_t  ack;
+    rt_uint8_t  tries;       /* device ID retries so far */
+    rt_int32_t  retries;     /* device ID retries allowed */
+    struct rt_semaphore done;
+};
+
 struct rt_sccb_ops
 {
     void *data;            /* private data for lowlevel routines */
@@ -24,15 +92,86 @@ struct rt_sccb_ops
     void (*set_scl)(void *data, rt_int32_t state);
     rt_int32_t (*get_sda)(void *data);
     rt_int32_t (*get_scl)(void *data);
+    /* optional, drive the RT_SCCB_LINE_* lines in mask to values at once */
+    void (*set_lines)(void *data, rt_uint32_t mask, rt_uint32_t values);
 
     void (*udelay)(rt_uint32_t us);
+    void (*ndelay)(rt_uint32_t ns);   /* optional, used with a timing profile */
 
     rt_uint32_t delay_us;  /* scl and sda line delay */
     rt_uint32_t timeout;   /* in tick */
+    rt_uint32_t timeout_us;  /* clock stretch deadline, 0 uses timeout */
+    rt_uint32_t spin_us;     /* busy-poll a stretched SCL this long, 0 for default */
+    rt_uint32_t stretch_us;      /* last observed clock stretch */
+    rt_uint32_t stretch_max_us;  /* longest observed clock stretch */
+    rt_uint32_t stretches;       /* clock stretch waits */
+    rt_uint32_t stretch_timeouts;
+    const struct rt_sccb_timing *timing;  /* per-phase delays, overrides delay_us */
+    struct rt_sccb_rate rates[RT_SCCB_RATES];  /* per-device timing, overrides both */
+#ifdef RT_SCCB_USING_TRACE
+    struct rt_sccb_trace *trace;          /* the bus trace ring, set by the core */
+#endif
+
+    /*
+     * optional, with fsm set the bus runs the interrupt-driven engine: call
+     * rt_sccb_fsm_tick() every period_ns from timer_start() until
+     * timer_stop(), which the engine calls from the tick itself.
+     */
+    rt_err_t (*timer_start)(void *data, rt_uint32_t period_ns);
+    void (*timer_stop)(void *data);
+    struct rt_sccb_fsm *fsm;
+
+    rt_uint8_t  lines;       /* shadow of the driven levels, kept by the core */
+    rt_uint8_t  lines_known; /* valid shadow lines, clear it after driving
+                                pins behind the core's back */
 };
 
+/* the timing the engine uses for a device: its calibrated one, else base */
+rt_inline const struct rt_sccb_timing *rt_sccb_rate_timing(const struct rt_sccb_ops   *ops,
+                                                           rt_uint16_t                addr,
+                                                           const struct rt_sccb_timing *base)
+{
+    rt_uint32_t i;
+
+    for (i = 0; i < RT_SCCB_RATES; i++)
+    {
+        if (ops->rates[i].used && ops->rates[i].addr == addr)
+            return &ops->rates[i].timing;
+    }
+
+    return base;
+}
+
+/*
+ * the messages from msgs[0] on that form one run of transactions to the same
+ * device, ended by a stop before a start to another device. Engines that
+ * can only switch settings between runs send a vector run by run.
+ */
+rt_inline rt_uint32_t rt_sccb_device_run(const struct rt_sccb_msg msgs[], rt_uint32_t num)
+{
+    rt_uint32_t n;
+
+    for (n = 1; n < num; n++)
+    {
+        if (msgs[n].addr != msgs[0].addr &&
+            !(msgs[n].flags & RT_SCCB_NO_START) &&
+            !(msgs[n - 1].flags & RT_SCCB_NO_STOP))
+            break;
+    }
+
+    return n;
+}
+
 rt_err_t rt_sccb_add_bus(struct rt_sccb_bus_device *bus,
                             const char               *bus_name);
+void rt_sccb_fsm_tick(struct rt_sccb_ops *ops);
+struct rt_sccb_ops *rt_sccb_bus_ops(struct rt_sccb_bus_device *bus);
+rt_err_t rt_sccb_stretch_wait(rt_int32_t (*scl_high)(void *data),
+                              void       (*udelay)(void *data, rt_uint32_t us),
+                              void        *data,
+                              rt_uint32_t spin_us,
+                              rt_uint32_t timeout_us,
+                              rt_uint32_t *waited_us);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,72 @@
+#ifndef __SOFT_SCCB_ASYNC_H__
+#define __SOFT_SCCB_ASYNC_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#ifndef RT_SCCB_ASYNC_RING_SIZE
+#define RT_SCCB_ASYNC_RING_SIZE     16      /* power of two */
+#endif
+
+struct rt_sccb_async_req;
+typedef void (*rt_sccb_async_done_t)(struct rt_sccb_async_req *req);
+
+/*
+ * one queued transaction, owned by the submitter until it completes.
+ * msgs and the request itself must stay valid until then.
+ */
+struct rt_sccb_async_req
+{
+    struct rt_sccb_msg   *msgs;
+    rt_uint32_t          num;
+
+    rt_sccb_async_done_t done;          /* called from the worker thread, or */
+    rt_event_t           event;         /* event_set sent when done is RT_NULL */
+    rt_uint32_t          event_set;
+    void                 *user_data;
+
+    rt_size_t            result;        /* messages completed */
+
+    /* storage for rt_sccb_async_write_reg() */
+    struct rt_sccb_msg   msg;
+    rt_uint8_t           val;
+};
+
+/* per-bus worker with a submission ring, ISR-safe on the producer side */
+struct rt_sccb_async
+{
+    struct rt_sccb_bus_device *bus;
+    rt_thread_t              thread;
+    struct rt_semaphore      pending;
+
+    struct rt_sccb_async_req *ring[RT_SCCB_ASYNC_RING_SIZE];
+    volatile rt_uint32_t     head;      /* advanced by the worker only */
+    volatile rt_uint32_t     tail;      /* advanced by submitters */
+};
+
+rt_err_t rt_sccb_async_init(struct rt_sccb_async     *async,
+                            struct rt_sccb_bus_device *bus,
+                            const char               *name,
+                            rt_uint32_t              stack_size,
+                            rt_uint8_t               priority);
+rt_err_t rt_sccb_async_submit(struct rt_sccb_async     *async,
+                              struct rt_sccb_async_req *req);
+rt_err_t rt_sccb_async_write_reg(struct rt_sccb_async     *async,
+                                 struct rt_sccb_async_req *req,
+                                 rt_uint16_t              addr,
+                                 rt_uint8_t               reg,
+                                 rt_uint8_t               val);
+rt_size_t rt_sccb_async_transfer(struct rt_sccb_async *async,
+                                 struct rt_sccb_msg   msgs[],
+                                 rt_uint32_t          num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
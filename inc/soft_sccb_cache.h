@@ -0,0 +1,54 @@
+#ifndef __SOFT_SCCB_CACHE_H__
+#define __SOFT_SCCB_CACHE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#define RT_SCCB_CACHE_REGS       256
+#define RT_SCCB_CACHE_WORDS      (RT_SCCB_CACHE_REGS / 32)
+
+/*
+ * write-through shadow of one device's 8-bit register file. Reads of
+ * cached non-volatile registers and writes of an unchanged value do not
+ * touch the bus. In cache-only mode writes are only recorded as dirty and
+ * go out on rt_sccb_regcache_sync().
+ */
+struct rt_sccb_regcache
+{
+    struct rt_sccb_bus_device *bus;
+    rt_uint16_t  addr;
+    rt_bool_t    cache_only;
+
+    rt_uint8_t   vals[RT_SCCB_CACHE_REGS];
+    rt_uint32_t  valid[RT_SCCB_CACHE_WORDS];
+    rt_uint32_t  dirty[RT_SCCB_CACHE_WORDS];
+    rt_uint32_t  volat[RT_SCCB_CACHE_WORDS];    /* always read from the device */
+};
+
+void rt_sccb_regcache_init(struct rt_sccb_regcache   *cache,
+                           struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr);
+rt_err_t rt_sccb_regcache_set_volatile(struct rt_sccb_regcache *cache,
+                                       rt_uint8_t              first,
+                                       rt_uint8_t              last,
+                                       rt_bool_t               is_volatile);
+rt_err_t rt_sccb_regcache_cache_only(struct rt_sccb_regcache *cache, rt_bool_t enable);
+rt_err_t rt_sccb_regcache_read(struct rt_sccb_regcache *cache,
+                               rt_uint8_t              reg,
+                               rt_uint8_t              *val);
+rt_err_t rt_sccb_regcache_write(struct rt_sccb_regcache *cache,
+                                rt_uint8_t              reg,
+                                rt_uint8_t              val);
+rt_err_t rt_sccb_regcache_sync(struct rt_sccb_regcache *cache);
+rt_err_t rt_sccb_regcache_invalidate(struct rt_sccb_regcache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef __SOFT_SCCB_CALIB_H__
+#define __SOFT_SCCB_CALIB_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb.h"
+#include "soft_sccb_wave.h"
+
+rt_err_t rt_sccb_calibrate(struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr,
+                           rt_uint8_t                reg,
+                           rt_uint8_t                margin,
+                           struct rt_sccb_timing     *result);
+rt_err_t rt_sccb_calibrate_clear(struct rt_sccb_bus_device *bus, rt_uint16_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,15 +9,119 @@ extern "C" {
 
 
 #define RT_SCCB_WR               (0)
-#define RT_SCCB_RD               (1)
+#define RT_SCCB_RD               (1u << 0)
+#define RT_SCCB_REG              (1u << 1)   /* send reg as sub-address after the ID */
+#define RT_SCCB_REG16            (1u << 2)   /* with RT_SCCB_REG: 16-bit sub-address, high byte first */
+#define RT_SCCB_BURST            (1u << 3)   /* data moves len bytes, else one */
+#define RT_SCCB_NO_START         (1u << 4)   /* continue previous msg: no start, no ID */
+#define RT_SCCB_IGNORE_NACK      (1u << 5)   /* treat the data phase ACK as don't care */
+#define RT_SCCB_NO_STOP          (1u << 7)   /* no stop after this msg, unless it is the last */
 
+/*
+ * one transaction phase. A message with data moves one byte, or len bytes
+ * in sequence with RT_SCCB_BURST, the device auto-incrementing the
+ * register. len is only looked at with RT_SCCB_BURST, so messages filled in
+ * field by field need not set it. Reads ACK every byte but the last one.
+ */
 struct rt_sccb_msg
 {
     rt_uint16_t addr;
     rt_uint16_t flags;
-    rt_uint8_t  *data;
+    rt_uint16_t reg;         /* sub-address, valid with RT_SCCB_REG */
+    rt_uint16_t len;         /* data bytes with RT_SCCB_BURST, 0 is taken as 1 */
+    rt_uint8_t  *data;       /* RT_NULL for a 2-phase write */
 };
 
+#define RT_SCCB_MSG_LEN(msg)     (((msg)->flags & RT_SCCB_BURST) && (msg)->len ? (msg)->len : 1)
+
+/*
+ * bus timing profile, all values in ns. scl_low_ns also covers the data
+ * setup time of bits driven at the falling SCL edge.
+ */
+struct rt_sccb_timing
+{
+    rt_uint32_t scl_high_ns;   /* SCL high period */
+    rt_uint32_t scl_low_ns;    /* SCL low period, also the bus free time */
+    rt_uint32_t su_dat_ns;     /* data setup when SDA moves inside a low period */
+    rt_uint32_t hd_sta_ns;     /* start hold, SDA low to SCL low */
+    rt_uint32_t su_sto_ns;     /* stop and repeated start setup */
+};
+
+/* SCCB specification figures for 100 kHz and 400 kHz */
+#define RT_SCCB_TIMING_100K     { 4000, 4700, 250, 4000, 4000 }
+#define RT_SCCB_TIMING_400K     { 600, 1300, 100, 600, 600 }
+
+#define RT_SCCB_STATS_BUCKETS   16
+
+/*
+ * bus counters, kept by the core and the bit engine under the bus lock.
+ * Histogram bucket 0 counts durations under 1 us, bucket n durations of
+ * [2^(n-1), 2^n) us and the last bucket everything longer.
+ */
+struct rt_sccb_bus_stats
+{
+    rt_uint32_t xfers;         /* rt_sccb_transfer() calls */
+    rt_uint32_t errors;        /* transfers that stopped before the last message */
+    rt_uint32_t msgs;          /* messages completed */
+    rt_uint32_t bytes;         /* bytes on the wire, device IDs included */
+    rt_uint32_t nacks;
+    rt_uint32_t retries;       /* device ID retries after a NACK */
+    rt_uint32_t stretches;     /* clock stretch waits */
+    rt_uint32_t timeouts;      /* clock stretch timeouts */
+    rt_uint32_t locks;         /* bus lock sessions, nested ones not counted */
+    rt_uint32_t preempts;      /* sessions handed to a more urgent waiter */
+
+    rt_uint32_t lock_max_us;   /* longest bus lock wait */
+    rt_uint32_t xfer_max_us;   /* longest master_xfer() */
+    rt_uint32_t lock_hist[RT_SCCB_STATS_BUCKETS];
+    rt_uint32_t xfer_hist[RT_SCCB_STATS_BUCKETS];
+};
+
+#ifdef RT_SCCB_USING_TRACE
+#ifndef RT_SCCB_TRACE_SIZE
+#define RT_SCCB_TRACE_SIZE      256     /* events, power of two */
+#endif
+
+/* one bus event, see RT_SCCB_TRACE_* in soft_sccb_trace.h */
+struct rt_sccb_trace_event
+{
+    rt_uint32_t time_us;
+    rt_uint8_t  type;
+    rt_uint8_t  data;
+    rt_uint8_t  ack;
+};
+
+/* event ring, written by the bus lock holder only */
+struct rt_sccb_trace
+{
+    struct rt_sccb_trace_event ring[RT_SCCB_TRACE_SIZE];
+    volatile rt_uint32_t head;          /* events recorded so far */
+};
+#endif
+
+/*
+ * bus lock arbitration key. Deadline holders go first, earliest deadline
+ * first, then the rest by thread priority. Equal keys queue in order.
+ */
+struct rt_sccb_bus_key
+{
+    rt_uint32_t deadline_us;   /* rt_sccb_get_us() time, valid with timed */
+    rt_uint8_t  timed;
+    rt_uint8_t  priority;      /* thread priority, lower is more urgent */
+};
+
+/* a thread queued for the bus lock, on its own stack */
+struct rt_sccb_bus_waiter
+{
+    rt_list_t              list;
+    rt_thread_t            thread;
+    rt_uint32_t            nest;    /* bus lock depth to resume with */
+    struct rt_sccb_bus_key key;
+};
+
+/* bus flags */
+#define RT_SCCB_BUS_F_SINGLE_CLIENT  (1u << 0)  /* one thread only, no waiter queue, arbitration or priority lending */
+
 /*for sccb bus driver*/
 struct rt_sccb_bus_device
 {
@@ -25,34 +129,59 @@ struct rt_sccb_bus_device
     const struct rt_sccb_bus_device_ops *ops;
     rt_uint16_t  flags;
     rt_uint16_t  addr;
-    struct rt_mutex lock;
+    rt_list_t    waiters;       /* rt_sccb_bus_waiter queue, most urgent first */
+    rt_thread_t  owner;         /* thread holding the bus lock */
+    rt_uint8_t   owner_prio;    /* owner priority before lending it a waiter's */
+    rt_uint32_t  nest;          /* bus lock depth of the owner */
+    struct rt_sccb_bus_key key; /* the owner's arbitration key */
     rt_uint32_t  timeout;
     rt_uint32_t  retries;
+    struct rt_sccb_bus_stats stats;
+    rt_list_t    clients;       /* attached rt_sccb_client profiles */
+#ifdef RT_SCCB_USING_TRACE
+    struct rt_sccb_trace trace;
+#endif
     void *priv;
 };
 
 struct rt_sccb_bus_device_ops
 {
     rt_size_t (*master_xfer)(struct rt_sccb_bus_device *bus,
-                             struct rt_sccb_msg *msg);
+                             struct rt_sccb_msg msgs[],
+                             rt_uint32_t num);
     rt_err_t (*sccb_bus_control)(struct rt_sccb_bus_device *bus,
                                 rt_uint32_t,
                                 rt_uint32_t);
 };
 
 
+/*
+ * one device on a bus. Once attached, its profile applies to every
+ * transaction with client_addr, whoever issues it.
+ */
 struct rt_sccb_client
 {
     struct rt_device               parent;
     struct rt_sccb_bus_device       *bus;
     rt_uint16_t                    client_addr;
+
+    const struct rt_sccb_timing    *timing;      /* RT_NULL for the bus timing */
+    rt_int32_t                     retries;      /* device ID retries, < 0 for the bus setting */
+    rt_uint32_t                    timeout_us;   /* clock stretch deadline, 0 for the bus setting */
+    rt_list_t                      list;         /* on the bus client list */
 };
 
 rt_err_t rt_sccb_bus_device_register(struct rt_sccb_bus_device *bus,
                                     const char               *bus_name);
 struct rt_sccb_bus_device *rt_sccb_bus_device_find(const char *bus_name);
+rt_err_t rt_sccb_bus_lock(struct rt_sccb_bus_device *bus);
+rt_err_t rt_sccb_bus_lock_until(struct rt_sccb_bus_device *bus,
+                                rt_uint32_t               deadline_us);
+rt_bool_t rt_sccb_bus_yield(struct rt_sccb_bus_device *bus);
+void rt_sccb_bus_unlock(struct rt_sccb_bus_device *bus);
 rt_size_t rt_sccb_transfer(struct rt_sccb_bus_device *bus,
-                          struct rt_sccb_msg         *msg);
+                          struct rt_sccb_msg         msgs[],
+                          rt_uint32_t                num);
 rt_size_t rt_sccb_master_send(struct rt_sccb_bus_device *bus,
                              rt_uint16_t               addr,
                              rt_uint16_t               flags,
@@ -61,6 +190,62 @@ rt_size_t rt_sccb_master_recv(struct rt_sccb_bus_device *bus,
                              rt_uint16_t               addr,
                              rt_uint16_t               flags,
                              rt_uint8_t                *data);
+rt_err_t rt_sccb_write_reg(struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr,
+                           rt_uint8_t                reg,
+                           rt_uint8_t                val);
+rt_err_t rt_sccb_read_reg(struct rt_sccb_bus_device *bus,
+                          rt_uint16_t               addr,
+                          rt_uint8_t                reg,
+                          rt_uint8_t                *val);
+rt_size_t rt_sccb_write_regs(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint8_t                reg,
+                             const rt_uint8_t          *vals,
+                             rt_size_t                 count);
+rt_size_t rt_sccb_read_regs(struct rt_sccb_bus_device *bus,
+                            rt_uint16_t               addr,
+                            rt_uint8_t                reg,
+                            rt_uint8_t                *vals,
+                            rt_size_t                 count);
+rt_err_t rt_sccb_write_burst(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint16_t               flags,
+                             rt_uint16_t               reg,
+                             const rt_uint8_t          *data,
+                             rt_uint16_t               len);
+rt_err_t rt_sccb_read_burst(struct rt_sccb_bus_device *bus,
+                            rt_uint16_t               addr,
+                            rt_uint16_t               flags,
+                            rt_uint16_t               reg,
+                            rt_uint8_t                *data,
+                            rt_uint16_t               len);
+rt_err_t rt_sccb_update_bits(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint8_t                reg,
+                             rt_uint8_t                mask,
+                             rt_uint8_t                val);
+rt_err_t rt_sccb_update_bits_check(struct rt_sccb_bus_device *bus,
+                                   rt_uint16_t               addr,
+                                   rt_uint8_t                reg,
+                                   rt_uint8_t                mask,
+                                   rt_uint8_t                val,
+                                   rt_bool_t                 *changed);
+rt_err_t rt_sccb_wait_reg(struct rt_sccb_bus_device *bus,
+                          rt_uint16_t               addr,
+                          rt_uint8_t                reg,
+                          rt_uint8_t                mask,
+                          rt_uint8_t                val,
+                          rt_uint32_t               timeout_us,
+                          rt_uint32_t               *elapsed_us);
+rt_err_t rt_sccb_client_attach(struct rt_sccb_client *client);
+void rt_sccb_client_detach(struct rt_sccb_client *client);
+struct rt_sccb_client *rt_sccb_client_find(struct rt_sccb_bus_device *bus,
+                                           rt_uint16_t               addr);
+rt_err_t rt_sccb_bus_stats_get(struct rt_sccb_bus_device *bus,
+                               struct rt_sccb_bus_stats  *stats);
+rt_err_t rt_sccb_bus_stats_reset(struct rt_sccb_bus_device *bus);
+rt_uint32_t rt_sccb_get_us(void);
 int rt_sccb_core_init(void);
 
 #ifdef __cplusplus
@@ -12,13 +12,21 @@ extern "C" {
 #define RT_SCCB_DEV_CTRL_ADDR         0x20
 #define RT_SCCB_DEV_CTRL_TIMEOUT      0x21
 #define RT_SCCB_DEV_CTRL_RW           0x22
+#define RT_SCCB_DEV_CTRL_STATS        0x23    /* args: struct rt_sccb_bus_stats * */
+#define RT_SCCB_DEV_CTRL_STATS_RESET  0x24
+#define RT_SCCB_DEV_CTRL_TRACE        0x25    /* args: struct rt_sccb_trace_export * */
+#define RT_SCCB_DEV_CTRL_TRACE_CLEAR  0x26
+#define RT_SCCB_DEV_CTRL_TIMING       0x27    /* args: const struct rt_sccb_timing *, clients only */
+#define RT_SCCB_DEV_CTRL_RETRIES      0x28    /* args: rt_int32_t * */
 
 struct rt_sccb_priv_data
 {
-    struct rt_sccb_msg  *msg;
+    struct rt_sccb_msg  *msgs;
+    rt_size_t           number;
 };
 
 rt_err_t rt_sccb_bus_device_device_init(struct rt_sccb_bus_device *bus, const char *name);
+rt_err_t rt_sccb_client_device_init(struct rt_sccb_client *client, const char *name);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,88 @@
+#ifndef __SOFT_SCCB_LANES_H__
+#define __SOFT_SCCB_LANES_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#ifndef RT_SCCB_LANES_MAX
+#define RT_SCCB_LANES_MAX       8
+#endif
+#ifndef RT_SCCB_LANES_TIMEOUT_US
+#define RT_SCCB_LANES_TIMEOUT_US 100000 /* clock stretch deadline when ops->timeout_us is 0 */
+#endif
+
+#define RT_SCCB_LANES_ALL       ((1u << RT_SCCB_LANES_MAX) - 1)
+
+/*
+ * port access of a multi-lane bus. All SDA lines and the SCL line(s) sit on
+ * one GPIO port, so a clock edge for every lane is a single port write and
+ * sampling every lane is a single port read.
+ */
+struct rt_sccb_lanes_ops
+{
+    void *data;
+    /* drive the port pins in mask to values at once, e.g. one BSRR write */
+    void (*set_port)(void *data, rt_uint32_t mask, rt_uint32_t values);
+    /* sample every port pin at once, e.g. one IDR read */
+    rt_uint32_t (*get_port)(void *data);
+
+    void (*udelay)(rt_uint32_t us);
+    void (*ndelay)(rt_uint32_t ns);   /* optional, used with a timing profile */
+
+    rt_uint32_t delay_us;             /* scl and sda line delay */
+    rt_uint32_t timeout_us;           /* clock stretch deadline, 0 for RT_SCCB_LANES_TIMEOUT_US */
+    rt_uint32_t spin_us;              /* busy-poll a stretched SCL this long, 0 for default */
+    const struct rt_sccb_timing *timing;  /* per-phase delays, overrides delay_us */
+};
+
+/*
+ * N identical buses clocked in lockstep by one engine. Lanes are numbered
+ * from 0, sda[n] is the port pin mask of lane n and scl the mask of the SCL
+ * pin, or of every lane's SCL pin when they are not shared. Lanes outside
+ * the mask of a transaction keep SDA released and see no start condition.
+ */
+struct rt_sccb_lanes
+{
+    const struct rt_sccb_lanes_ops *ops;
+    rt_uint32_t  sda[RT_SCCB_LANES_MAX];
+    rt_uint32_t  scl;
+    rt_uint8_t   num;
+
+    struct rt_mutex lock;
+    rt_uint32_t  sda_all;             /* every lane's SDA pins */
+    rt_uint32_t  port;                /* shadow of the driven levels */
+
+    /* counters */
+    rt_uint32_t  stretch_us;          /* last observed clock stretch */
+    rt_uint32_t  stretch_max_us;      /* longest observed clock stretch */
+    rt_uint32_t  stretches;           /* clock stretch waits */
+    rt_uint32_t  stretch_timeouts;
+};
+
+rt_err_t rt_sccb_lanes_init(struct rt_sccb_lanes *lanes, const char *name);
+rt_uint32_t rt_sccb_lanes_write_reg(struct rt_sccb_lanes *lanes,
+                                    rt_uint32_t          lane_mask,
+                                    rt_uint16_t          addr,
+                                    rt_uint8_t           reg,
+                                    const rt_uint8_t     vals[]);
+rt_uint32_t rt_sccb_lanes_write_reg_all(struct rt_sccb_lanes *lanes,
+                                        rt_uint32_t          lane_mask,
+                                        rt_uint16_t          addr,
+                                        rt_uint8_t           reg,
+                                        rt_uint8_t           val);
+rt_uint32_t rt_sccb_lanes_read_reg(struct rt_sccb_lanes *lanes,
+                                   rt_uint32_t          lane_mask,
+                                   rt_uint16_t          addr,
+                                   rt_uint8_t           reg,
+                                   rt_uint8_t           vals[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
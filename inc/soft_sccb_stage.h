@@ -0,0 +1,76 @@
+#ifndef __SOFT_SCCB_STAGE_H__
+#define __SOFT_SCCB_STAGE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#ifndef RT_SCCB_STAGE_SIZE
+#define RT_SCCB_STAGE_SIZE      32      /* distinct registers per commit */
+#endif
+
+/* one staged register write */
+struct rt_sccb_stage_entry
+{
+    rt_uint16_t addr;
+    rt_uint8_t  reg;
+    rt_uint8_t  val;
+};
+
+struct rt_sccb_stage;
+typedef void (*rt_sccb_stage_done_t)(struct rt_sccb_stage *stage, rt_err_t result);
+
+/*
+ * register writes collected between two frame triggers. Writes to a
+ * register already in the set only replace its value. A commit sends the
+ * whole set as one transfer, from a VSYNC or blanking trigger through the
+ * commit thread, or directly with rt_sccb_stage_commit().
+ *
+ * Writers fill one set while the other is on the wire, so staging never
+ * waits for the bus.
+ */
+struct rt_sccb_stage
+{
+    struct rt_sccb_bus_device *bus;
+    rt_uint32_t              budget_us;     /* commit deadline after the trigger */
+
+    struct rt_sccb_stage_entry set[2][RT_SCCB_STAGE_SIZE];
+    rt_uint16_t              num[2];
+    rt_uint8_t               fill;          /* the set writers stage into */
+
+    rt_thread_t              thread;
+    struct rt_semaphore      trigger;
+    volatile rt_uint32_t     trigger_us;    /* time of the last trigger */
+    rt_sccb_stage_done_t     done;          /* called from the commit thread */
+    void                     *user_data;
+
+    /* counters */
+    rt_uint32_t              commits;
+    rt_uint32_t              writes;        /* registers sent */
+    rt_uint32_t              merges;        /* staged writes that replaced a value */
+};
+
+void rt_sccb_stage_init(struct rt_sccb_stage      *stage,
+                        struct rt_sccb_bus_device *bus,
+                        rt_uint32_t               budget_us);
+rt_err_t rt_sccb_stage_write(struct rt_sccb_stage *stage,
+                             rt_uint16_t          addr,
+                             rt_uint8_t           reg,
+                             rt_uint8_t           val);
+rt_err_t rt_sccb_stage_commit(struct rt_sccb_stage *stage);
+void rt_sccb_stage_discard(struct rt_sccb_stage *stage);
+rt_err_t rt_sccb_stage_start(struct rt_sccb_stage *stage,
+                             const char           *name,
+                             rt_uint32_t          stack_size,
+                             rt_uint8_t           priority);
+void rt_sccb_stage_trigger(struct rt_sccb_stage *stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
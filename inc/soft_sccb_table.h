@@ -0,0 +1,50 @@
+#ifndef __SOFT_SCCB_TABLE_H__
+#define __SOFT_SCCB_TABLE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#define RT_SCCB_TAB_OP_WRITE     (0x00)   /* reg = val */
+#define RT_SCCB_TAB_OP_MASK      (0x01)   /* reg = (reg & ~mask) | (val & mask) */
+#define RT_SCCB_TAB_OP_DELAY     (0x02)   /* sleep (mask << 8 | val) ms */
+#define RT_SCCB_TAB_OP_WAIT      (0x03)   /* poll until (reg & mask) == val, up to bus->timeout */
+#define RT_SCCB_TAB_OP_VERIFY    (0x04)   /* fail unless (reg & mask) == val */
+#define RT_SCCB_TAB_OP_YIELD     (0x05)   /* let a more urgent bus user in, see rt_sccb_bus_yield() */
+#define RT_SCCB_TAB_OP_END       (0x0f)   /* end of table */
+#define RT_SCCB_TAB_OP_MSK       (0x0f)
+#define RT_SCCB_TAB_F_VERIFY     (0x80)   /* read back after WRITE/MASK */
+
+/* one init table entry, 4 bytes, meant to live in flash */
+struct rt_sccb_reg_entry
+{
+    rt_uint8_t op;
+    rt_uint8_t reg;
+    rt_uint8_t val;
+    rt_uint8_t mask;
+};
+
+#define RT_SCCB_TAB_WRITE(reg, val)          { RT_SCCB_TAB_OP_WRITE, (reg), (val), 0xff }
+#define RT_SCCB_TAB_WRITE_VERIFY(reg, val)   { RT_SCCB_TAB_OP_WRITE | RT_SCCB_TAB_F_VERIFY, (reg), (val), 0xff }
+#define RT_SCCB_TAB_MASK(reg, mask, val)     { RT_SCCB_TAB_OP_MASK, (reg), (val), (mask) }
+#define RT_SCCB_TAB_DELAY(ms)                { RT_SCCB_TAB_OP_DELAY, 0, (ms) & 0xff, ((ms) >> 8) & 0xff }
+#define RT_SCCB_TAB_WAIT(reg, mask, val)     { RT_SCCB_TAB_OP_WAIT, (reg), (val), (mask) }
+#define RT_SCCB_TAB_VERIFY(reg, mask, val)   { RT_SCCB_TAB_OP_VERIFY, (reg), (val), (mask) }
+#define RT_SCCB_TAB_YIELD()                  { RT_SCCB_TAB_OP_YIELD, 0, 0, 0 }
+#define RT_SCCB_TAB_END()                    { RT_SCCB_TAB_OP_END, 0, 0, 0 }
+
+rt_err_t rt_sccb_write_table(struct rt_sccb_bus_device       *bus,
+                             rt_uint16_t                     addr,
+                             const struct rt_sccb_reg_entry  *table,
+                             rt_size_t                       count,
+                             rt_size_t                       *fail_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef __SOFT_SCCB_TRACE_H__
+#define __SOFT_SCCB_TRACE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb_core.h"
+
+#define RT_SCCB_TRACE_START          1
+#define RT_SCCB_TRACE_STOP           2
+#define RT_SCCB_TRACE_WRITE          3       /* data: byte, ack: 1 if acknowledged */
+#define RT_SCCB_TRACE_READ           4       /* data: byte */
+#define RT_SCCB_TRACE_STRETCH_BEGIN  5
+#define RT_SCCB_TRACE_STRETCH_END    6
+#define RT_SCCB_TRACE_TIMEOUT        7       /* clock stretch timeout */
+#define RT_SCCB_TRACE_RETRY          8       /* data: device ID that was NACKed */
+
+#define RT_SCCB_TRACE_FMT_LOG        0       /* one decoded line per transaction */
+#define RT_SCCB_TRACE_FMT_VCD        1       /* value change dump, 1 us timescale */
+
+typedef void (*rt_sccb_trace_out_t)(void *ctx, const char *str);
+
+/* args of RT_SCCB_DEV_CTRL_TRACE */
+struct rt_sccb_trace_export
+{
+    rt_uint8_t          format;
+    rt_sccb_trace_out_t out;
+    void                *ctx;
+};
+
+#ifdef RT_SCCB_USING_TRACE
+/* single producer, the bus lock holder, so a slot store and an index bump */
+rt_inline void rt_sccb_trace_record(struct rt_sccb_trace *trace,
+                                    rt_uint8_t           type,
+                                    rt_uint8_t           data,
+                                    rt_uint8_t           ack)
+{
+    struct rt_sccb_trace_event *ev;
+
+    ev = &trace->ring[trace->head & (RT_SCCB_TRACE_SIZE - 1)];
+    ev->time_us = rt_sccb_get_us();
+    ev->type    = type;
+    ev->data    = data;
+    ev->ack     = ack;
+    trace->head++;
+}
+#endif
+
+rt_err_t rt_sccb_trace_export(struct rt_sccb_bus_device *bus,
+                              rt_uint8_t               format,
+                              rt_sccb_trace_out_t      out,
+                              void                     *ctx);
+rt_err_t rt_sccb_trace_clear(struct rt_sccb_bus_device *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef __SOFT_SCCB_WAVE_H__
+#define __SOFT_SCCB_WAVE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "soft_sccb.h"
+
+#ifndef RT_SCCB_WAVE_SYMS
+#define RT_SCCB_WAVE_SYMS       128     /* bit symbols per buffer, a register write takes 29 */
+#endif
+
+/*
+ * line state slot flags. A symbol is one SCL period split into four slots,
+ * slot n in bits [8n+7:8n] of the symbol word. A slot drives the
+ * RT_SCCB_LINE_* lines it holds high and releases the others.
+ */
+#define RT_SCCB_WAVE_SAMPLE     (1u << 2)   /* sample SDA into the capture buffer */
+#define RT_SCCB_WAVE_WAIT       (1u << 3)   /* SCL was released, hold while a slave stretches it */
+
+/*
+ * a transaction precompiled into line states, clocked out one slot per tick
+ * by a periodic timer or by rt_sccb_wave_run() in a loop. Read bits and ACKs
+ * are sampled into capture and turned back into message data by
+ * rt_sccb_wave_decode().
+ *
+ * A data phase longer than the buffer is split: compile cuts it, leaving
+ * the transaction open, and the next buffer continues it at offset without
+ * a start condition.
+ *
+ * The player drives the lines through the rt_sccb_ops line routines, which
+ * must be filled in even with RT_SCCB_USING_INLINE_PORT.
+ */
+struct rt_sccb_wave
+{
+    struct rt_sccb_ops *ops;
+    /*
+     * optional timer backend: call rt_sccb_wave_tick() every slot_ns from a
+     * periodic timer until it returns RT_TRUE, then return. Without it the
+     * waveform is replayed in a delay loop.
+     */
+    rt_err_t (*play)(struct rt_sccb_wave *wave);
+
+    rt_uint32_t slot_ns;        /* slot period, set by rt_sccb_wave_run() */
+    rt_uint32_t sym[RT_SCCB_WAVE_SYMS];
+    rt_uint8_t  capture[(RT_SCCB_WAVE_SYMS + 7) / 8];
+    rt_uint16_t len;            /* compiled symbols */
+    rt_uint16_t offset;         /* data bytes of msgs[0] played by earlier buffers */
+    rt_uint16_t part;           /* data bytes compiled of a message cut at the buffer end */
+
+    /* player state */
+    rt_uint16_t pos;
+    rt_uint8_t  slot;
+    rt_uint8_t  lines;          /* driven levels */
+    rt_uint16_t samples;
+    rt_uint32_t stall;          /* ticks the current slot waited for SCL */
+    rt_uint32_t stall_max;
+    volatile rt_uint8_t done;
+    rt_err_t    status;
+
+    /* counters of the last decode */
+    rt_uint32_t bytes;
+    rt_uint32_t nacks;
+};
+
+rt_uint32_t rt_sccb_wave_compile(struct rt_sccb_wave *wave,
+                                 struct rt_sccb_msg  msgs[],
+                                 rt_uint32_t         num);
+rt_bool_t rt_sccb_wave_tick(struct rt_sccb_wave *wave);
+rt_err_t rt_sccb_wave_run(struct rt_sccb_wave *wave);
+rt_uint32_t rt_sccb_wave_decode(struct rt_sccb_wave *wave,
+                                struct rt_sccb_msg  msgs[],
+                                rt_uint32_t         num);
+rt_err_t rt_sccb_add_wave_bus(struct rt_sccb_bus_device *bus,
+                              const char               *bus_name);
+struct rt_sccb_ops *rt_sccb_wave_bus_ops(struct rt_sccb_bus_device *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
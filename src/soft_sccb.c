@@ -1,5 +1,6 @@
 #include <rtthread.h>
 #include "soft_sccb.h"
+#include "soft_sccb_trace.h"
 
 #define DBG_TAG               "SCCB"
 #ifdef RT_SCCB_DEBUG
@@ -9,88 +10,294 @@
 #endif
 #include <rtdbg.h>
 
+#ifdef RT_SCCB_USING_INLINE_PORT
+/* line primitives come from the port header and get inlined into the engine */
+#include RT_SCCB_PORT_HEADER
+
+#define SET_SDA(ops, val)   sccb_port_set_sda(ops->data, val)
+#define SET_SCL(ops, val)   sccb_port_set_scl(ops->data, val)
+#define GET_SDA(ops)        sccb_port_get_sda(ops->data)
+#define GET_SCL(ops)        sccb_port_get_scl(ops->data)
+#define UDELAY(ops, us)     sccb_port_udelay(us)
+#ifdef SCCB_PORT_HAS_NDELAY
+#define NDELAY(ops, ns)     sccb_port_ndelay(ns)
+#else
+#define NDELAY(ops, ns)     sccb_port_udelay(((ns) + 999) / 1000)
+#endif
+#define HAS_GET_SCL(ops)    (1)
+#ifdef SCCB_PORT_HAS_SET_LINES
+#define SET_LINES(ops, m, v) sccb_port_set_lines(ops->data, m, v)
+#define HAS_SET_LINES(ops)  (1)
+#else
+#define SET_LINES(ops, m, v)
+#define HAS_SET_LINES(ops)  (0)
+#endif
+#else
 #define SET_SDA(ops, val)   ops->set_sda(ops->data, val)
 #define SET_SCL(ops, val)   ops->set_scl(ops->data, val)
 #define GET_SDA(ops)        ops->get_sda(ops->data)
 #define GET_SCL(ops)        ops->get_scl(ops->data)
+#define UDELAY(ops, us)     ops->udelay(us)
+#define NDELAY(ops, ns)     (ops->ndelay ? ops->ndelay(ns) : ops->udelay(((ns) + 999) / 1000))
+#define HAS_GET_SCL(ops)    (ops->get_scl != RT_NULL)
+#define SET_LINES(ops, m, v) ops->set_lines(ops->data, m, v)
+#define HAS_SET_LINES(ops)  (ops->set_lines != RT_NULL)
+#endif
+
+#ifdef RT_SCCB_USING_TRACE
+#define TRACE(ops, type, data, ack) rt_sccb_trace_record(ops->trace, type, data, ack)
+#else
+#define TRACE(ops, type, data, ack) do { } while (0)
+#endif
+
+#define LINE_SDA            RT_SCCB_LINE_SDA
+#define LINE_SCL            RT_SCCB_LINE_SCL
 
 rt_inline void sccb_delay(struct rt_sccb_ops *ops)
 {
-    ops->udelay((ops->delay_us + 1) >> 1);
+    UDELAY(ops, (ops->delay_us + 1) >> 1);
 }
 
+/* inter-byte gap, only used without a timing profile */
 rt_inline void sccb_delay2(struct rt_sccb_ops *ops)
 {
-    ops->udelay(ops->delay_us);
+    if (!ops->timing)
+        UDELAY(ops, ops->delay_us);
+}
+
+rt_inline void sccb_ndelay(struct rt_sccb_ops *ops, rt_uint32_t ns)
+{
+    if (ns)
+        NDELAY(ops, ns);
 }
 
-#define SDA_L(ops)          SET_SDA(ops, 0)
-#define SDA_H(ops)          SET_SDA(ops, 1)
-#define SCL_L(ops)          SET_SCL(ops, 0)
+/* one bus phase: the profile value when a timing profile is set, else half of delay_us */
+#define PHASE_DELAY(ops, phase)                         \
+    do                                                  \
+    {                                                   \
+        if (ops->timing)                                \
+            sccb_ndelay(ops, ops->timing->phase);       \
+        else                                            \
+            sccb_delay(ops);                            \
+    } while (0)
+
+/* a delay the legacy timing has but no profile phase maps to */
+#define LEGACY_DELAY(ops)                               \
+    do                                                  \
+    {                                                   \
+        if (!ops->timing)                               \
+            sccb_delay(ops);                            \
+    } while (0)
 
 /**
- * release scl line, and wait scl line to high.
+ * drive the lines in mask to values, skipping lines whose shadowed level
+ * already matches. When SCL falls together with an SDA change, SCL goes
+ * first, so a port without set_lines still keeps the data hold time.
  */
-static rt_err_t SCL_H(struct rt_sccb_ops *ops)
+rt_inline void sccb_drive(struct rt_sccb_ops *ops, rt_uint8_t mask, rt_uint8_t values)
 {
-    rt_tick_t start;
+    rt_uint8_t change;
+
+    change = mask & ~(ops->lines_known & ~(ops->lines ^ values));
+    if (!change)
+        return;
+
+    if (HAS_SET_LINES(ops))
+    {
+        SET_LINES(ops, change, values & change);
+    }
+    else
+    {
+        if ((change & LINE_SCL) && !(values & LINE_SCL))
+            SET_SCL(ops, 0);
+        if (change & LINE_SDA)
+            SET_SDA(ops, (values & LINE_SDA) ? 1 : 0);
+        if ((change & LINE_SCL) && (values & LINE_SCL))
+            SET_SCL(ops, 1);
+    }
+    ops->lines = (ops->lines & ~change) | (values & change);
+    ops->lines_known |= change;
+}
+
+#define SDA_L(ops)          sccb_drive(ops, LINE_SDA, 0)
+#define SDA_H(ops)          sccb_drive(ops, LINE_SDA, LINE_SDA)
+#define SCL_L(ops)          sccb_drive(ops, LINE_SCL, 0)
+/* pull SCL low and put the next data bit on SDA, in one port write if possible */
+#define SCL_L_SDA(ops, bit) sccb_drive(ops, LINE_SCL | LINE_SDA, (bit) ? LINE_SDA : 0)
 
-    SET_SCL(ops, 1);
+#define US_PER_TICK         (1000000 / RT_TICK_PER_SECOND)
+
+/**
+ * This function waits for a slave that stretches the clock: it busy-polls
+ * scl_high() every microsecond for spin_us, then yields and sleeps with
+ * exponential back-off until the deadline. A deadline shorter than
+ * spin_us cuts the busy-poll short. The bit engines share it.
+ *
+ * @param scl_high returns non-zero once SCL reads high.
+ * @param udelay the microsecond busy delay.
+ * @param data passed to both routines.
+ * @param spin_us the busy-poll time, 0 for RT_SCCB_STRETCH_SPIN_US.
+ * @param timeout_us the deadline.
+ * @param waited_us the time SCL was held low, also set on timeout.
+ *
+ * @return RT_EOK once SCL is high, -RT_ETIMEOUT at the deadline.
+ */
+rt_err_t rt_sccb_stretch_wait(rt_int32_t (*scl_high)(void *data),
+                              void       (*udelay)(void *data, rt_uint32_t us),
+                              void        *data,
+                              rt_uint32_t spin_us,
+                              rt_uint32_t timeout_us,
+                              rt_uint32_t *waited_us)
+{
+    rt_uint32_t spun = 0, waited = 0;
+    rt_tick_t start, sleep = 0, left;
 
-    if (!ops->get_scl)
-        goto done;
+    if (spin_us == 0)
+        spin_us = RT_SCCB_STRETCH_SPIN_US;
+    if (spin_us > timeout_us)
+        spin_us = timeout_us;
 
-    start = rt_tick_get();
-    while (!GET_SCL(ops))
+    while (!scl_high(data))
     {
-        if ((rt_tick_get() - start) > ops->timeout)
+        if (waited >= timeout_us)
+        {
+            *waited_us = timeout_us;
+
             return -RT_ETIMEOUT;
-        rt_thread_delay((ops->timeout + 1) >> 1);
+        }
+        if (spun < spin_us)
+        {
+            udelay(data, 1);
+            waited = ++spun;
+            continue;
+        }
+
+        if (sleep == 0)
+        {
+            start = rt_tick_get();
+            rt_thread_yield();
+            sleep = 1;
+        }
+        else
+        {
+            /* never sleep past the deadline */
+            left = (timeout_us - waited + US_PER_TICK - 1) / US_PER_TICK;
+            rt_thread_delay(sleep < left ? sleep : left);
+            if (sleep * US_PER_TICK < timeout_us / 4)
+                sleep <<= 1;
+        }
+        waited = spun + (rt_tick_get() - start) * US_PER_TICK;
     }
-#ifdef RT_SCCB_DEBUG
-    if (rt_tick_get() != start)
+    *waited_us = waited;
+
+    return RT_EOK;
+}
+
+static rt_int32_t sccb_scl_level(void *data)
+{
+    struct rt_sccb_ops *ops = (struct rt_sccb_ops *)data;
+
+    return GET_SCL(ops);
+}
+
+static void sccb_udelay(void *data, rt_uint32_t us)
+{
+    UDELAY(((struct rt_sccb_ops *)data), us);
+}
+
+/**
+ * wait for a slave that stretches the clock. The observed stretch is
+ * recorded in the ops.
+ */
+static rt_err_t sccb_wait_scl(struct rt_sccb_ops *ops)
+{
+    rt_uint32_t timeout_us = ops->timeout_us ? ops->timeout_us : ops->timeout * US_PER_TICK;
+    rt_uint32_t waited;
+
+    TRACE(ops, RT_SCCB_TRACE_STRETCH_BEGIN, 0, 0);
+    ops->stretches++;
+    if (rt_sccb_stretch_wait(sccb_scl_level, sccb_udelay, ops, ops->spin_us,
+                             timeout_us, &waited) != RT_EOK)
     {
-        LOG_D("wait %ld tick for SCL line to go high",
-              rt_tick_get() - start);
+        ops->stretch_timeouts++;
+        TRACE(ops, RT_SCCB_TRACE_TIMEOUT, 0, 0);
+
+        return -RT_ETIMEOUT;
+    }
+
+    TRACE(ops, RT_SCCB_TRACE_STRETCH_END, 0, 0);
+    ops->stretch_us = waited;
+    if (waited > ops->stretch_max_us)
+        ops->stretch_max_us = waited;
+
+    LOG_D("wait %d us for SCL line to go high", waited);
+
+    return RT_EOK;
+}
+
+/**
+ * release scl line, and wait scl line to high.
+ */
+static rt_err_t SCL_H(struct rt_sccb_ops *ops)
+{
+    sccb_drive(ops, LINE_SCL, LINE_SCL);
+
+    if (HAS_GET_SCL(ops) && !GET_SCL(ops))
+    {
+        if (sccb_wait_scl(ops) != RT_EOK)
+            return -RT_ETIMEOUT;
     }
-#endif
 
-done:
-    sccb_delay(ops);
+    PHASE_DELAY(ops, scl_high_ns);
 
     return RT_EOK;
 }
 
 static void sccb_start(struct rt_sccb_ops *ops)
 {
+    TRACE(ops, RT_SCCB_TRACE_START, 0, 0);
     SDA_H(ops);
     SCL_H(ops);
-    sccb_delay(ops);
+    /* a repeated start needs the same setup as a stop */
+    PHASE_DELAY(ops, su_sto_ns);
     SDA_L(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, hd_sta_ns);
     SCL_L(ops);
 }
 
 static void sccb_stop(struct rt_sccb_ops *ops)
 {
     SDA_L(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, scl_low_ns);
     SCL_H(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, su_sto_ns);
     SDA_H(ops);
-    sccb_delay(ops);
+    TRACE(ops, RT_SCCB_TRACE_STOP, 0, 0);
+    /* bus free time before the next start */
+    PHASE_DELAY(ops, scl_low_ns);
 }
 
 static void sccb_no_ack(struct rt_sccb_ops *ops)
 {
-    sccb_delay(ops);
+    LEGACY_DELAY(ops);
     SDA_H(ops);
     SCL_H(ops);
-    sccb_delay(ops);
+    LEGACY_DELAY(ops);
     SCL_L(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, scl_low_ns);
+    SDA_L(ops);
+    PHASE_DELAY(ops, su_dat_ns);
+}
+
+/* master ACK, the slave keeps sending */
+static void sccb_ack(struct rt_sccb_ops *ops)
+{
+    LEGACY_DELAY(ops);
     SDA_L(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, su_dat_ns);
+    SCL_H(ops);
+    LEGACY_DELAY(ops);
+    SCL_L(ops);
 }
 
 static rt_int32_t sccb_writeb(struct rt_sccb_bus_device *bus, rt_uint8_t data)
@@ -103,10 +310,9 @@ static rt_int32_t sccb_writeb(struct rt_sccb_bus_device *bus, rt_uint8_t data)
 
     for (i = 7; i >= 0; i--)
     {
-        SCL_L(ops);
         bit = (data >> i) & 1;
-        SET_SDA(ops, bit);
-        sccb_delay(ops);
+        SCL_L_SDA(ops, bit);
+        PHASE_DELAY(ops, scl_low_ns);
         if (SCL_H(ops) < 0)
         {
             LOG_D("sccb_writeb: 0x%02x, "
@@ -116,13 +322,18 @@ static rt_int32_t sccb_writeb(struct rt_sccb_bus_device *bus, rt_uint8_t data)
             return -RT_ETIMEOUT;
         }
     }
-    SDA_H(ops);
-    sccb_delay(ops);
+    SCL_L_SDA(ops, 1);
+    PHASE_DELAY(ops, scl_low_ns);
     SCL_H(ops);
-    sccb_delay(ops);
+    LEGACY_DELAY(ops);
     res=!GET_SDA(ops);
     SCL_L(ops);
 
+    bus->stats.bytes++;
+    if (!res)
+        bus->stats.nacks++;
+    TRACE(ops, RT_SCCB_TRACE_WRITE, data, res);
+
     return res;
 }
 
@@ -133,7 +344,7 @@ static rt_int32_t sccb_readb(struct rt_sccb_bus_device *bus)
     struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
 
     SDA_H(ops);
-    sccb_delay(ops);
+    PHASE_DELAY(ops, scl_low_ns);
     for (i = 0; i < 8; i++)
     {
         data <<= 1;
@@ -149,8 +360,10 @@ static rt_int32_t sccb_readb(struct rt_sccb_bus_device *bus)
         if (GET_SDA(ops))
             data |= 1;
         SCL_L(ops);
-        sccb_delay(ops);
+        PHASE_DELAY(ops, scl_low_ns);
     }
+    bus->stats.bytes++;
+    TRACE(ops, RT_SCCB_TRACE_READ, data, 0);
 
     return data;
 }
@@ -158,15 +371,21 @@ static rt_int32_t sccb_readb(struct rt_sccb_bus_device *bus)
 static rt_size_t sccb_write_reg(struct rt_sccb_bus_device *bus,
                                 struct rt_sccb_msg        *msg)
 {
+    rt_uint16_t i, len = RT_SCCB_MSG_LEN(msg);
     rt_int32_t ret;
 
-    ret = sccb_writeb(bus, *(msg->data));
-
-    if (ret == 0)
+    for (i = 0; i < len; i++)
     {
-        LOG_E("send bytes: error %d", ret);
+        ret = sccb_writeb(bus, msg->data[i]);
+        if (ret == 0 && (msg->flags & RT_SCCB_IGNORE_NACK))
+            ret = 1;
+
+        if (ret != 1)
+        {
+            LOG_E("send bytes: error %d at byte %d", ret, i);
 
-        return ret;
+            return 0;
+        }
     }
 
     return 1;
@@ -175,18 +394,29 @@ static rt_size_t sccb_write_reg(struct rt_sccb_bus_device *bus,
 static rt_size_t sccb_read_reg(struct rt_sccb_bus_device *bus,
                                 struct rt_sccb_msg        *msg)
 {
+    rt_uint16_t i, len = RT_SCCB_MSG_LEN(msg);
     rt_int32_t val;
     struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
 
-    val = sccb_readb(bus);
-    if (val >= 0)
+    for (i = 0; i < len; i++)
     {
-        *(msg->data) = val;
-    }
+        val = sccb_readb(bus);
+        if (val < 0)
+        {
+            LOG_E("recieve byte: error %d at byte %d", val, i);
 
-    LOG_D("recieve byte: 0x%02x", val);
+            return 0;
+        }
+        msg->data[i] = val;
+
+        LOG_D("recieve byte: 0x%02x", val);
 
-    sccb_no_ack(ops);
+        /* ACK keeps an auto-increment read going, NACK ends it */
+        if (i + 1 < len)
+            sccb_ack(ops);
+        else
+            sccb_no_ack(ops);
+    }
 
     return 1;
 }
@@ -204,9 +434,11 @@ static rt_int32_t sccb_send_dev_address(struct rt_sccb_bus_device *bus,
         ret = sccb_writeb(bus, addr);
         if (ret == 1 || i == retries)
             break;
+        bus->stats.retries++;
+        TRACE(ops, RT_SCCB_TRACE_RETRY, addr, 0);
         LOG_D("send stop condition");
         sccb_stop(ops);
-        sccb_delay(ops);
+        LEGACY_DELAY(ops);
         LOG_D("send start condition");
         sccb_start(ops);
     }
@@ -215,16 +447,14 @@ static rt_int32_t sccb_send_dev_address(struct rt_sccb_bus_device *bus,
 }
 
 static rt_err_t sccb_send_address(struct rt_sccb_bus_device *bus,
-                                     struct rt_sccb_msg        *msg)
+                                     struct rt_sccb_msg        *msg,
+                                     rt_int32_t                retries)
 {
     rt_uint16_t flags = msg->flags;
 
     rt_uint8_t addr;
-    rt_int32_t retries;
     rt_err_t ret;
 
-    retries = bus->retries;
-
     /* 7-bit addr */
     addr = msg->addr << 1;
     if (flags & RT_SCCB_RD)
@@ -236,47 +466,515 @@ static rt_err_t sccb_send_address(struct rt_sccb_bus_device *bus,
     return RT_EOK;
 }
 
-static rt_size_t sccb_xfer(struct rt_sccb_bus_device *bus, struct rt_sccb_msg *msg)
+static rt_size_t sccb_xfer_msg(struct rt_sccb_bus_device *bus,
+                               struct rt_sccb_msg        *msg)
 {
     struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
     rt_int32_t ret;
-    LOG_D("send start condition");
-    sccb_start(ops);
-    if (!(msg->flags))
+
+    if (!(msg->flags & RT_SCCB_RD) && (msg->flags & RT_SCCB_REG))
     {
-        ret = sccb_send_address(bus, msg);
-        if (ret != RT_EOK)
+        /* phase 2: register sub-address, high byte first */
+        ret = 1;
+        if (msg->flags & RT_SCCB_REG16)
+            ret = sccb_writeb(bus, msg->reg >> 8);
+        if (ret == 1)
+            ret = sccb_writeb(bus, msg->reg & 0xff);
+        if (ret != 1)
         {
-            LOG_D("receive NACK from device addr 0x%02x msg %d",
-                    msgs[i].addr, i);
-            goto out;
+            LOG_D("receive NACK for sub-address 0x%04x", msg->reg);
+
+            return 0;
         }
+        sccb_delay2(ops);
+    }
+    if (msg->data == RT_NULL)
+    {
+        /* 2-phase write, only the sub-address is sent */
+        return 1;
     }
-    sccb_delay2(ops);
     if (msg->flags & RT_SCCB_RD)
+        return sccb_read_reg(bus, msg);
+
+    return sccb_write_reg(bus, msg);
+}
+
+/* the bus settings a transfer starts from */
+struct sccb_base
+{
+    const struct rt_sccb_timing *timing;
+    rt_uint32_t timeout_us;
+};
+
+/**
+ * switch the engine to the settings of a device: those of its client, else
+ * its calibrated rate, else the bus settings.
+ *
+ * @return the device ID retries.
+ */
+static rt_int32_t sccb_select(struct rt_sccb_bus_device *bus,
+                              struct rt_sccb_ops        *ops,
+                              const struct sccb_base    *base,
+                              rt_uint16_t               addr)
+{
+    struct rt_sccb_client *client = rt_sccb_client_find(bus, addr);
+
+    ops->timing     = rt_sccb_rate_timing(ops, addr, base->timing);
+    ops->timeout_us = base->timeout_us;
+    if (client == RT_NULL)
+        return bus->retries;
+
+    if (client->timing)
+        ops->timing = client->timing;
+    if (client->timeout_us)
+        ops->timeout_us = client->timeout_us;
+
+    return client->retries < 0 ? (rt_int32_t)bus->retries : client->retries;
+}
+
+static rt_size_t sccb_xfer(struct rt_sccb_bus_device *bus,
+                           struct rt_sccb_msg         msgs[],
+                           rt_uint32_t                num)
+{
+    struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
+    struct sccb_base base;
+    struct rt_sccb_msg *msg;
+    rt_uint32_t i;
+    rt_int32_t ret, retries;
+    rt_bool_t stopped = RT_TRUE;
+    rt_uint32_t stretches = ops->stretches;
+    rt_uint32_t timeouts = ops->stretch_timeouts;
+
+    if (num > 0 && (msgs[0].flags & RT_SCCB_NO_START))
+    {
+        LOG_E("msg 0 has RT_SCCB_NO_START, there is no transaction to continue");
+
+        return 0;
+    }
+
+    base.timing     = ops->timing;
+    base.timeout_us = ops->timeout_us;
+    for (i = 0; i < num; i++)
     {
-        ret = sccb_read_reg(bus, msg);
-        if (ret == 0)
+        msg = &msgs[i];
+        if (!(msg->flags & RT_SCCB_NO_START))
+        {
+            /* each device runs at its own settings */
+            retries = sccb_select(bus, ops, &base, msg->addr);
+            LOG_D("send start condition");
+            sccb_start(ops);
+            stopped = RT_FALSE;
+            ret = sccb_send_address(bus, msg, retries);
+            if (ret != RT_EOK)
+            {
+                LOG_D("receive NACK from device addr 0x%02x msg %d",
+                        msg->addr, i);
+                break;
+            }
+            sccb_delay2(ops);
+        }
+        if (sccb_xfer_msg(bus, msg) != 1)
+            break;
+        if (!(msg->flags & RT_SCCB_NO_STOP) && i + 1 < num)
         {
-            ret = -RT_EIO;
-            goto out;
+            LOG_D("send stop condition");
+            sccb_stop(ops);
+            stopped = RT_TRUE;
         }
     }
+
+    if (!stopped)
+    {
+        LOG_D("send stop condition");
+        sccb_stop(ops);
+    }
+    ops->timing     = base.timing;
+    ops->timeout_us = base.timeout_us;
+
+    /* the line level helpers only see the ops, fold their counts in here */
+    bus->stats.stretches += ops->stretches - stretches;
+    bus->stats.timeouts  += ops->stretch_timeouts - timeouts;
+
+    return i;
+}
+
+/* interrupt-driven engine, one bus phase per rt_sccb_fsm_tick() */
+enum
+{
+    FSM_IDLE = 0,
+    FSM_START,          /* release SDA */
+    FSM_START_SCL,      /* release SCL */
+    FSM_START_SDA,      /* pull SDA low while SCL is high */
+    FSM_BYTE,           /* first bit of the next byte */
+    FSM_BIT_HIGH,       /* release SCL */
+    FSM_BIT_SAMPLE,     /* sample at the end of the high period */
+    FSM_STOP_SCL,       /* release SCL, SDA is low */
+    FSM_STOP_SDA,       /* release SDA while SCL is high */
+    FSM_BUS_FREE,
+};
+
+enum
+{
+    FSM_STEP_ADDR = 0,
+    FSM_STEP_REG,       /* sub-address, the high byte of a 16-bit one */
+    FSM_STEP_REG_LO,
+    FSM_STEP_DATA,
+};
+
+enum
+{
+    FSM_THEN_FINISH = 0,
+    FSM_THEN_NEXT,      /* start the next message */
+    FSM_THEN_RETRY,     /* start the same message again */
+};
+
+static void fsm_phase(struct rt_sccb_ops *ops, rt_uint8_t step);
+
+/* pull SCL low with the next bit on SDA */
+static void fsm_bit(struct rt_sccb_ops *ops)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+    rt_uint8_t sda = 1;
+
+    if (fsm->bit < 8 && !fsm->rx)
+        sda = (fsm->shift >> (7 - fsm->bit)) & 1;
+    else if (fsm->bit == 8 && fsm->rx)
+        /* ACK every read byte but the last */
+        sda = fsm->pos + 1 >= RT_SCCB_MSG_LEN(&fsm->msgs[fsm->index]);
+    SCL_L_SDA(ops, sda);
+    fsm->state = FSM_BIT_HIGH;
+}
+
+static void fsm_byte(struct rt_sccb_ops *ops, rt_uint8_t step, rt_uint8_t byte, rt_uint8_t rx)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+
+    fsm->step  = step;
+    fsm->shift = byte;
+    fsm->rx    = rx;
+    fsm->bit   = 0;
+    fsm_bit(ops);
+}
+
+static void fsm_stop(struct rt_sccb_ops *ops, rt_uint8_t then)
+{
+    ops->fsm->then  = then;
+    sccb_drive(ops, LINE_SCL | LINE_SDA, 0);
+    ops->fsm->state = FSM_STOP_SCL;
+}
+
+static void fsm_msg_done(struct rt_sccb_ops *ops)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+    struct rt_sccb_msg *msg = &fsm->msgs[fsm->index];
+
+    fsm->index++;
+    fsm->tries = 0;
+    if (fsm->index == fsm->num)
+    {
+        fsm_stop(ops, FSM_THEN_FINISH);
+    }
+    else if (!(msg->flags & RT_SCCB_NO_STOP))
+    {
+        fsm_stop(ops, FSM_THEN_NEXT);
+    }
+    else if (fsm->msgs[fsm->index].flags & RT_SCCB_NO_START)
+    {
+        fsm_phase(ops, FSM_STEP_REG);
+    }
     else
     {
-        ret = sccb_write_reg(bus, msg);
-        if (ret == 0)
+        /* repeated start, SDA may only rise while SCL is low */
+        TRACE(ops, RT_SCCB_TRACE_START, 0, 0);
+        sccb_drive(ops, LINE_SCL | LINE_SDA, LINE_SDA);
+        fsm->state = FSM_START_SCL;
+    }
+}
+
+/* clock out the first phase from step on that the current message has */
+static void fsm_phase(struct rt_sccb_ops *ops, rt_uint8_t step)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+    struct rt_sccb_msg *msg = &fsm->msgs[fsm->index];
+
+    if (step == FSM_STEP_ADDR)
+    {
+        fsm_byte(ops, step, (msg->addr << 1) | ((msg->flags & RT_SCCB_RD) ? 1 : 0), 0);
+        return;
+    }
+    if (step != FSM_STEP_DATA && !(msg->flags & RT_SCCB_RD) && (msg->flags & RT_SCCB_REG))
+    {
+        if (step == FSM_STEP_REG && (msg->flags & RT_SCCB_REG16))
         {
-            ret = -RT_ERROR;
-            goto out;
+            fsm_byte(ops, step, msg->reg >> 8, 0);
+            return;
         }
+        fsm_byte(ops, FSM_STEP_REG_LO, msg->reg & 0xff, 0);
+        return;
+    }
+    if (msg->data != RT_NULL)
+    {
+        fsm->pos = 0;
+        if (msg->flags & RT_SCCB_RD)
+            fsm_byte(ops, FSM_STEP_DATA, 0, 1);
+        else
+            fsm_byte(ops, FSM_STEP_DATA, msg->data[0], 0);
+        return;
     }
+    fsm_msg_done(ops);
+}
 
-out:
-    LOG_D("send stop condition");
-    sccb_stop(ops);
+/* the 9th bit was sampled, account for the byte and pick the next phase */
+static void fsm_byte_done(struct rt_sccb_ops *ops)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+    struct rt_sccb_bus_device *bus = fsm->bus;
+    struct rt_sccb_msg *msg = &fsm->msgs[fsm->index];
 
-    return 1;
+    bus->stats.bytes++;
+    if (fsm->rx)
+    {
+        TRACE(ops, RT_SCCB_TRACE_READ, fsm->shift, 0);
+        msg->data[fsm->pos] = fsm->shift;
+        if (++fsm->pos < RT_SCCB_MSG_LEN(msg))
+            fsm_byte(ops, FSM_STEP_DATA, 0, 1);
+        else
+            fsm_msg_done(ops);
+        return;
+    }
+
+    TRACE(ops, RT_SCCB_TRACE_WRITE, fsm->shift, fsm->ack);
+    if (!fsm->ack)
+        bus->stats.nacks++;
+
+    switch (fsm->step)
+    {
+    case FSM_STEP_ADDR:
+        if (fsm->ack)
+        {
+            fsm_phase(ops, FSM_STEP_REG);
+        }
+        else if (fsm->tries < fsm->retries)
+        {
+            fsm->tries++;
+            bus->stats.retries++;
+            TRACE(ops, RT_SCCB_TRACE_RETRY, fsm->shift, 0);
+            fsm_stop(ops, FSM_THEN_RETRY);
+        }
+        else
+        {
+            fsm_stop(ops, FSM_THEN_FINISH);
+        }
+        break;
+    case FSM_STEP_REG:
+    case FSM_STEP_REG_LO:
+        if (fsm->ack)
+            fsm_phase(ops, fsm->step + 1);
+        else
+            fsm_stop(ops, FSM_THEN_FINISH);
+        break;
+    default:
+        if (!fsm->ack && !(msg->flags & RT_SCCB_IGNORE_NACK))
+            fsm_stop(ops, FSM_THEN_FINISH);
+        else if (++fsm->pos < RT_SCCB_MSG_LEN(msg))
+            fsm_byte(ops, FSM_STEP_DATA, msg->data[fsm->pos], 0);
+        else
+            fsm_msg_done(ops);
+        break;
+    }
+}
+
+/* RT_TRUE while a slave holds SCL low, the transfer is abandoned at the deadline */
+static rt_bool_t fsm_stretched(struct rt_sccb_ops *ops)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+
+    if (!HAS_GET_SCL(ops) || GET_SCL(ops))
+    {
+        if (fsm->stall)
+        {
+            TRACE(ops, RT_SCCB_TRACE_STRETCH_END, 0, 0);
+            ops->stretches++;
+        }
+        fsm->stall = 0;
+
+        return RT_FALSE;
+    }
+
+    if (fsm->stall++ == 0)
+        TRACE(ops, RT_SCCB_TRACE_STRETCH_BEGIN, 0, 0);
+    if (fsm->stall > fsm->stall_max)
+    {
+        ops->stretches++;
+        ops->stretch_timeouts++;
+        TRACE(ops, RT_SCCB_TRACE_TIMEOUT, 0, 0);
+        fsm->stall = 0;
+        /* give up on the transfer and let go of the lines */
+        sccb_drive(ops, LINE_SCL | LINE_SDA, LINE_SCL | LINE_SDA);
+        fsm->then  = FSM_THEN_FINISH;
+        fsm->state = FSM_BUS_FREE;
+    }
+
+    return RT_TRUE;
+}
+
+/**
+ * This function advances the interrupt-driven engine by one bus phase. The
+ * port calls it from its periodic timer interrupt, and the engine stops the
+ * timer once the transfer has finished.
+ *
+ * @param ops the bit operations of the bus.
+ */
+void rt_sccb_fsm_tick(struct rt_sccb_ops *ops)
+{
+    struct rt_sccb_fsm *fsm = ops->fsm;
+
+    switch (fsm->state)
+    {
+    case FSM_START:
+        TRACE(ops, RT_SCCB_TRACE_START, 0, 0);
+        SDA_H(ops);
+        fsm->state = FSM_START_SCL;
+        break;
+    case FSM_START_SCL:
+        sccb_drive(ops, LINE_SCL, LINE_SCL);
+        fsm->state = FSM_START_SDA;
+        break;
+    case FSM_START_SDA:
+        if (fsm_stretched(ops))
+            break;
+        SDA_L(ops);
+        fsm->state = FSM_BYTE;
+        break;
+    case FSM_BYTE:
+        fsm_phase(ops, FSM_STEP_ADDR);
+        break;
+    case FSM_BIT_HIGH:
+        sccb_drive(ops, LINE_SCL, LINE_SCL);
+        fsm->state = FSM_BIT_SAMPLE;
+        break;
+    case FSM_BIT_SAMPLE:
+        if (fsm_stretched(ops))
+            break;
+        if (fsm->bit < 8)
+        {
+            if (fsm->rx)
+                fsm->shift = (fsm->shift << 1) | (GET_SDA(ops) ? 1 : 0);
+        }
+        else if (!fsm->rx)
+        {
+            fsm->ack = !GET_SDA(ops);
+        }
+        if (++fsm->bit < 9)
+            fsm_bit(ops);
+        else
+            fsm_byte_done(ops);
+        break;
+    case FSM_STOP_SCL:
+        sccb_drive(ops, LINE_SCL, LINE_SCL);
+        fsm->state = FSM_STOP_SDA;
+        break;
+    case FSM_STOP_SDA:
+        if (fsm_stretched(ops))
+            break;
+        SDA_H(ops);
+        TRACE(ops, RT_SCCB_TRACE_STOP, 0, 0);
+        fsm->state = FSM_BUS_FREE;
+        break;
+    case FSM_BUS_FREE:
+        if (fsm->then == FSM_THEN_FINISH)
+        {
+            fsm->state = FSM_IDLE;
+            ops->timer_stop(ops->data);
+            rt_sem_release(&fsm->done);
+            break;
+        }
+        /* the next message, or the same one after a NACKed device ID */
+        TRACE(ops, RT_SCCB_TRACE_START, 0, 0);
+        fsm->state = FSM_START_SCL;
+        break;
+    default:
+        break;
+    }
+}
+
+/* clock one device run out from the bus timer, at the settings of its device */
+static rt_size_t sccb_fsm_run(struct rt_sccb_bus_device *bus,
+                              struct rt_sccb_msg         msgs[],
+                              rt_uint32_t                num)
+{
+    struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
+    struct rt_sccb_fsm *fsm = ops->fsm;
+    const struct rt_sccb_timing *timing;
+    struct sccb_base base;
+    rt_uint32_t timeout_us, period_ns;
+
+    base.timing     = ops->timing;
+    base.timeout_us = ops->timeout_us;
+    fsm->retries = sccb_select(bus, ops, &base, msgs[0].addr);
+    timing     = ops->timing;
+    timeout_us = ops->timeout_us ? ops->timeout_us : ops->timeout * US_PER_TICK;
+    ops->timing     = base.timing;
+    ops->timeout_us = base.timeout_us;
+    if (timing)
+        period_ns = timing->scl_high_ns > timing->scl_low_ns ?
+                    timing->scl_high_ns : timing->scl_low_ns;
+    else
+        period_ns = ((ops->delay_us + 1) >> 1) * 1000;
+
+    fsm->bus       = bus;
+    fsm->msgs      = msgs;
+    fsm->num       = num;
+    fsm->index     = 0;
+    fsm->tries     = 0;
+    fsm->stall     = 0;
+    fsm->stall_max = (rt_uint32_t)((rt_uint64_t)timeout_us * 1000 / (period_ns ? period_ns : 1));
+    fsm->state     = FSM_START;
+
+    if (ops->timer_start(ops->data, period_ns) != RT_EOK)
+    {
+        fsm->state = FSM_IDLE;
+        LOG_E("start of the bus timer failed");
+
+        return 0;
+    }
+    rt_sem_take(&fsm->done, RT_WAITING_FOREVER);
+
+    return fsm->index;
+}
+
+static rt_size_t sccb_fsm_xfer(struct rt_sccb_bus_device *bus,
+                               struct rt_sccb_msg         msgs[],
+                               rt_uint32_t                num)
+{
+    struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
+    rt_uint32_t stretches = ops->stretches;
+    rt_uint32_t timeouts = ops->stretch_timeouts;
+    rt_uint32_t done = 0, n, ok;
+
+    if (num == 0)
+        return 0;
+    if (msgs[0].flags & RT_SCCB_NO_START)
+    {
+        LOG_E("msg 0 has RT_SCCB_NO_START, there is no transaction to continue");
+
+        return 0;
+    }
+
+    /* the timer period is fixed while it runs, restart it for each device */
+    while (done < num)
+    {
+        n  = rt_sccb_device_run(&msgs[done], num - done);
+        ok = sccb_fsm_run(bus, &msgs[done], n);
+        done += ok;
+        if (ok != n)
+            break;
+    }
+
+    bus->stats.stretches += ops->stretches - stretches;
+    bus->stats.timeouts  += ops->stretch_timeouts - timeouts;
+
+    return done;
 }
 
 static const struct rt_sccb_bus_device_ops sccb_bus_ops =
@@ -285,10 +983,49 @@ static const struct rt_sccb_bus_device_ops sccb_bus_ops =
     RT_NULL
 };
 
+static const struct rt_sccb_bus_device_ops sccb_fsm_bus_ops =
+{
+    sccb_fsm_xfer,
+    RT_NULL
+};
+
 rt_err_t rt_sccb_add_bus(struct rt_sccb_bus_device *bus,
                             const char               *bus_name)
 {
+    struct rt_sccb_ops *ops = (struct rt_sccb_ops *)bus->priv;
+
+    /* line levels are unknown until the engine first drives them */
+    ops->lines_known = 0;
+#ifdef RT_SCCB_USING_TRACE
+    bus->trace.head = 0;
+    ops->trace = &bus->trace;
+#endif
     bus->ops = &sccb_bus_ops;
+    if (ops->fsm && ops->timer_start)
+    {
+        /* the port has a bus timer, run transfers from its interrupt */
+        ops->fsm->state = FSM_IDLE;
+        rt_sem_init(&ops->fsm->done, bus_name, 0, RT_IPC_FLAG_FIFO);
+        bus->ops = &sccb_fsm_bus_ops;
+    }
 
     return rt_sccb_bus_device_register(bus, bus_name);
 }
+
+/**
+ * This function returns the line routines of a bus run by the bit engine,
+ * from a thread or from its bus timer.
+ *
+ * @param bus the SCCB bus.
+ *
+ * @return the ops, RT_NULL if another engine runs the bus.
+ */
+struct rt_sccb_ops *rt_sccb_bus_ops(struct rt_sccb_bus_device *bus)
+{
+    RT_ASSERT(bus != RT_NULL);
+
+    if (bus->ops != &sccb_bus_ops && bus->ops != &sccb_fsm_bus_ops)
+        return RT_NULL;
+
+    return (struct rt_sccb_ops *)bus->priv;
+}
@@ -0,0 +1,180 @@
+#include <rtthread.h>
+#include <rthw.h>
+#include "soft_sccb_async.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#define RING_MASK             (RT_SCCB_ASYNC_RING_SIZE - 1)
+
+static void sccb_async_entry(void *parameter)
+{
+    struct rt_sccb_async *async = (struct rt_sccb_async *)parameter;
+    struct rt_sccb_async_req *req;
+
+    while (1)
+    {
+        rt_sem_take(&async->pending, RT_WAITING_FOREVER);
+
+        /* single consumer, the slot is only reused once head moves past it */
+        req = async->ring[async->head & RING_MASK];
+        async->head++;
+
+        /* the request belongs to the submitter again once it is signalled */
+        req->result = rt_sccb_transfer(async->bus, req->msgs, req->num);
+        if (req->done)
+            req->done(req);
+        else if (req->event)
+            rt_event_send(req->event, req->event_set);
+    }
+}
+
+/**
+ * This function starts the transaction worker of a bus.
+ *
+ * @param async the worker object.
+ * @param bus the SCCB bus it serves.
+ * @param name the worker thread name.
+ * @param stack_size the worker thread stack size.
+ * @param priority the worker thread priority.
+ *
+ * @return RT_EOK on success, -RT_ENOMEM if the thread can not be created.
+ */
+rt_err_t rt_sccb_async_init(struct rt_sccb_async     *async,
+                            struct rt_sccb_bus_device *bus,
+                            const char               *name,
+                            rt_uint32_t              stack_size,
+                            rt_uint8_t               priority)
+{
+    RT_ASSERT(async != RT_NULL);
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT((RT_SCCB_ASYNC_RING_SIZE & RING_MASK) == 0);
+
+    rt_memset(async, 0, sizeof(*async));
+    async->bus = bus;
+    rt_sem_init(&async->pending, name, 0, RT_IPC_FLAG_FIFO);
+
+    async->thread = rt_thread_create(name, sccb_async_entry, async,
+                                     stack_size, priority, 10);
+    if (async->thread == RT_NULL)
+    {
+        rt_sem_detach(&async->pending);
+
+        return -RT_ENOMEM;
+    }
+
+    return rt_thread_startup(async->thread);
+}
+
+/**
+ * This function queues a transaction. It does not block and may be called
+ * from interrupt context.
+ *
+ * @param async the worker object.
+ * @param req the request, msgs/num and the completion fields filled in.
+ *
+ * @return RT_EOK when queued, -RT_EFULL when the ring is full.
+ */
+rt_err_t rt_sccb_async_submit(struct rt_sccb_async     *async,
+                              struct rt_sccb_async_req *req)
+{
+    rt_base_t level;
+
+    RT_ASSERT(async != RT_NULL);
+    RT_ASSERT(req != RT_NULL);
+
+    req->result = 0;
+
+    /* the reservation is a few instructions, mask interrupts instead of locking */
+    level = rt_hw_interrupt_disable();
+    if (async->tail - async->head >= RT_SCCB_ASYNC_RING_SIZE)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EFULL;
+    }
+    async->ring[async->tail & RING_MASK] = req;
+    async->tail++;
+    rt_hw_interrupt_enable(level);
+
+    rt_sem_release(&async->pending);
+
+    return RT_EOK;
+}
+
+/**
+ * This function queues a 3-phase register write using the storage inside
+ * the request, so an ISR needs nothing but the request object.
+ *
+ * @param async the worker object.
+ * @param req the request, done/event fields filled in.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param val the value to write.
+ *
+ * @return RT_EOK when queued, -RT_EFULL when the ring is full.
+ */
+rt_err_t rt_sccb_async_write_reg(struct rt_sccb_async     *async,
+                                 struct rt_sccb_async_req *req,
+                                 rt_uint16_t              addr,
+                                 rt_uint8_t               reg,
+                                 rt_uint8_t               val)
+{
+    RT_ASSERT(req != RT_NULL);
+
+    req->val       = val;
+    req->msg.addr  = addr;
+    req->msg.flags = RT_SCCB_WR | RT_SCCB_REG;
+    req->msg.reg   = reg;
+    req->msg.len   = 1;
+    req->msg.data  = &req->val;
+    req->msgs      = &req->msg;
+    req->num       = 1;
+
+    return rt_sccb_async_submit(async, req);
+}
+
+static void sccb_async_wakeup(struct rt_sccb_async_req *req)
+{
+    rt_sem_release((rt_sem_t)req->user_data);
+}
+
+/**
+ * This function runs a transaction through the worker and waits for it, so
+ * it is ordered after everything queued before it.
+ *
+ * @param async the worker object.
+ * @param msgs the messages.
+ * @param num the number of messages.
+ *
+ * @return the number of messages completed.
+ */
+rt_size_t rt_sccb_async_transfer(struct rt_sccb_async *async,
+                                 struct rt_sccb_msg   msgs[],
+                                 rt_uint32_t          num)
+{
+    struct rt_sccb_async_req req;
+    struct rt_semaphore done;
+
+    RT_ASSERT(async != RT_NULL);
+    RT_ASSERT(rt_thread_self() != async->thread);
+
+    rt_memset(&req, 0, sizeof(req));
+    rt_sem_init(&done, "sccb_as", 0, RT_IPC_FLAG_FIFO);
+    req.msgs      = msgs;
+    req.num       = num;
+    req.done      = sccb_async_wakeup;
+    req.user_data = &done;
+
+    while (rt_sccb_async_submit(async, &req) == -RT_EFULL)
+        rt_thread_delay(1);
+    rt_sem_take(&done, RT_WAITING_FOREVER);
+    rt_sem_detach(&done);
+
+    return req.result;
+}
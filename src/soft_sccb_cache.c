@@ -0,0 +1,292 @@
+#include <rtthread.h>
+#include "soft_sccb_cache.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#define SYNC_BATCH            16
+
+#define BIT_WORD(reg)         ((reg) >> 5)
+#define BIT_MASK(reg)         (1ul << ((reg) & 31))
+#define TEST_BIT(map, reg)    ((map)[BIT_WORD(reg)] & BIT_MASK(reg))
+#define SET_BIT(map, reg)     ((map)[BIT_WORD(reg)] |= BIT_MASK(reg))
+#define CLEAR_BIT(map, reg)   ((map)[BIT_WORD(reg)] &= ~BIT_MASK(reg))
+
+/*
+ * bus sessions nest, holding one also guards the cache itself. Only a sync
+ * lets go of it, at its preemption points.
+ */
+rt_inline rt_err_t cache_lock(struct rt_sccb_regcache *cache)
+{
+    return rt_sccb_bus_lock(cache->bus);
+}
+
+rt_inline void cache_unlock(struct rt_sccb_regcache *cache)
+{
+    rt_sccb_bus_unlock(cache->bus);
+}
+
+/**
+ * This function sets up an empty cache for one device. All registers start
+ * out non-volatile.
+ *
+ * @param cache the cache.
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ */
+void rt_sccb_regcache_init(struct rt_sccb_regcache   *cache,
+                           struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr)
+{
+    RT_ASSERT(cache != RT_NULL);
+    RT_ASSERT(bus != RT_NULL);
+
+    rt_memset(cache, 0, sizeof(*cache));
+    cache->bus  = bus;
+    cache->addr = addr;
+}
+
+/**
+ * This function marks a register range as volatile (status, counters) or
+ * cacheable again.
+ *
+ * @param cache the cache.
+ * @param first the first register.
+ * @param last the last register, inclusive.
+ * @param is_volatile RT_TRUE to always read the range from the device.
+ *
+ * @return RT_EOK on success, the error of rt_sccb_bus_lock() otherwise.
+ */
+rt_err_t rt_sccb_regcache_set_volatile(struct rt_sccb_regcache *cache,
+                                       rt_uint8_t              first,
+                                       rt_uint8_t              last,
+                                       rt_bool_t               is_volatile)
+{
+    rt_uint32_t reg;
+    rt_err_t ret;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    for (reg = first; reg <= last; reg++)
+    {
+        if (is_volatile)
+        {
+            SET_BIT(cache->volat, reg);
+            CLEAR_BIT(cache->valid, reg);
+        }
+        else
+        {
+            CLEAR_BIT(cache->volat, reg);
+        }
+    }
+    cache_unlock(cache);
+
+    return RT_EOK;
+}
+
+/**
+ * This function switches cache-only mode. While it is on, writes only
+ * update the cache and mark the register dirty, e.g. while the sensor is
+ * powered down.
+ *
+ * @param cache the cache.
+ * @param enable RT_TRUE to defer writes until rt_sccb_regcache_sync().
+ *
+ * @return RT_EOK on success, the error of rt_sccb_bus_lock() otherwise.
+ */
+rt_err_t rt_sccb_regcache_cache_only(struct rt_sccb_regcache *cache, rt_bool_t enable)
+{
+    rt_err_t ret;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    cache->cache_only = enable;
+    cache_unlock(cache);
+
+    return RT_EOK;
+}
+
+/**
+ * This function reads a register, from the cache when it holds a valid
+ * copy of a non-volatile register and from the device otherwise.
+ *
+ * @param cache the cache.
+ * @param reg the register sub-address.
+ * @param val the buffer receiving the value.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond, the
+ *         error of rt_sccb_bus_lock() if the bus could not be taken.
+ */
+rt_err_t rt_sccb_regcache_read(struct rt_sccb_regcache *cache,
+                               rt_uint8_t              reg,
+                               rt_uint8_t              *val)
+{
+    rt_err_t ret = RT_EOK;
+
+    RT_ASSERT(cache != RT_NULL);
+    RT_ASSERT(val != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    if (TEST_BIT(cache->valid, reg))
+    {
+        *val = cache->vals[reg];
+    }
+    else
+    {
+        ret = rt_sccb_read_reg(cache->bus, cache->addr, reg, val);
+        if (ret == RT_EOK && !TEST_BIT(cache->volat, reg))
+        {
+            cache->vals[reg] = *val;
+            SET_BIT(cache->valid, reg);
+        }
+    }
+    cache_unlock(cache);
+
+    return ret;
+}
+
+/**
+ * This function writes a register through the cache. Rewriting the value
+ * a non-volatile register already holds does not touch the bus.
+ *
+ * @param cache the cache.
+ * @param reg the register sub-address.
+ * @param val the value to write.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond, the
+ *         error of rt_sccb_bus_lock() if the bus could not be taken.
+ */
+rt_err_t rt_sccb_regcache_write(struct rt_sccb_regcache *cache,
+                                rt_uint8_t              reg,
+                                rt_uint8_t              val)
+{
+    rt_err_t ret = RT_EOK;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    if (TEST_BIT(cache->valid, reg) && cache->vals[reg] == val)
+        goto out;
+
+    if (TEST_BIT(cache->volat, reg))
+    {
+        /* nothing is cached for volatile registers, not even in cache-only mode */
+        ret = rt_sccb_write_reg(cache->bus, cache->addr, reg, val);
+        goto out;
+    }
+
+    cache->vals[reg] = val;
+    SET_BIT(cache->valid, reg);
+    SET_BIT(cache->dirty, reg);
+    if (cache->cache_only)
+        goto out;
+
+    ret = rt_sccb_write_reg(cache->bus, cache->addr, reg, val);
+    /* on failure the device state is unknown, read it back next time */
+    if (ret != RT_EOK)
+        CLEAR_BIT(cache->valid, reg);
+    CLEAR_BIT(cache->dirty, reg);
+
+out:
+    cache_unlock(cache);
+
+    return ret;
+}
+
+/**
+ * This function writes every dirty register to the device, batching the
+ * writes into message vectors. More urgent bus users may slip in between
+ * batches and change the cache meanwhile, so after one did the scan starts
+ * over from the first register.
+ *
+ * @param cache the cache.
+ *
+ * @return RT_EOK on success, -RT_EIO if a write failed. Registers that were
+ *         not written stay dirty.
+ */
+rt_err_t rt_sccb_regcache_sync(struct rt_sccb_regcache *cache)
+{
+    struct rt_sccb_msg msgs[SYNC_BATCH];
+    rt_uint8_t regs[SYNC_BATCH];
+    rt_uint32_t reg, i, num;
+    rt_size_t done;
+    rt_err_t ret = RT_EOK;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    reg = 0;
+    while (reg < RT_SCCB_CACHE_REGS && ret == RT_EOK)
+    {
+        for (num = 0; reg < RT_SCCB_CACHE_REGS && num < SYNC_BATCH; reg++)
+        {
+            if (!TEST_BIT(cache->dirty, reg))
+                continue;
+            regs[num]        = reg;
+            msgs[num].addr   = cache->addr;
+            msgs[num].flags  = RT_SCCB_WR | RT_SCCB_REG;
+            msgs[num].reg    = reg;
+            msgs[num].len    = 1;
+            msgs[num].data   = &cache->vals[reg];
+            num++;
+        }
+        if (num == 0)
+            break;
+
+        done = rt_sccb_transfer(cache->bus, msgs, num);
+        for (i = 0; i < done; i++)
+            CLEAR_BIT(cache->dirty, regs[i]);
+        if (done != num)
+        {
+            LOG_E("cache sync of device 0x%02x failed at reg 0x%02x",
+                  cache->addr, regs[done]);
+            ret = -RT_EIO;
+        }
+        if (rt_sccb_bus_yield(cache->bus))
+            reg = 0;
+    }
+    cache_unlock(cache);
+
+    return ret;
+}
+
+/**
+ * This function drops every cached value, including dirty ones that were
+ * not synced yet, e.g. after the device was reset.
+ *
+ * @param cache the cache.
+ *
+ * @return RT_EOK on success, the error of rt_sccb_bus_lock() otherwise.
+ */
+rt_err_t rt_sccb_regcache_invalidate(struct rt_sccb_regcache *cache)
+{
+    rt_err_t ret;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    ret = cache_lock(cache);
+    if (ret != RT_EOK)
+        return ret;
+    rt_memset(cache->valid, 0, sizeof(cache->valid));
+    rt_memset(cache->dirty, 0, sizeof(cache->dirty));
+    cache_unlock(cache);
+
+    return RT_EOK;
+}
@@ -0,0 +1,241 @@
+#include <rtthread.h>
+#include "soft_sccb_calib.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#define CALIB_MIN_PERCENT     5       /* do not sweep below 1/20 of the bus timing */
+#define CALIB_ROUNDS          2       /* pattern passes per step */
+
+static const rt_uint8_t calib_pattern[] = { 0x55, 0xaa, 0x00, 0xff, 0x5a, 0xa5 };
+
+/* the timing the bus runs at without calibration, in profile form */
+static void calib_base(const struct rt_sccb_ops *ops, struct rt_sccb_timing *base)
+{
+    rt_uint32_t phase_ns;
+
+    if (ops->timing)
+    {
+        *base = *ops->timing;
+        return;
+    }
+
+    /* every legacy phase is half of delay_us */
+    phase_ns = ((ops->delay_us + 1) >> 1) * 1000;
+    base->scl_high_ns = phase_ns;
+    base->scl_low_ns  = phase_ns;
+    base->su_dat_ns   = phase_ns;
+    base->hd_sta_ns   = phase_ns;
+    base->su_sto_ns   = phase_ns;
+}
+
+static void calib_scale(const struct rt_sccb_timing *base,
+                        rt_uint32_t                 percent,
+                        struct rt_sccb_timing       *timing)
+{
+    timing->scl_high_ns = base->scl_high_ns * percent / 100;
+    timing->scl_low_ns  = base->scl_low_ns * percent / 100;
+    timing->su_dat_ns   = base->su_dat_ns * percent / 100;
+    timing->hd_sta_ns   = base->hd_sta_ns * percent / 100;
+    timing->su_sto_ns   = base->su_sto_ns * percent / 100;
+}
+
+/* the line routines holding the rate table, RT_NULL if the engine has none */
+static struct rt_sccb_ops *calib_ops(struct rt_sccb_bus_device *bus)
+{
+    struct rt_sccb_ops *ops = rt_sccb_bus_ops(bus);
+
+    return ops ? ops : rt_sccb_wave_bus_ops(bus);
+}
+
+/* the rate slot of a device, a free one if it has none */
+static struct rt_sccb_rate *calib_slot(struct rt_sccb_ops *ops, rt_uint16_t addr)
+{
+    struct rt_sccb_rate *free = RT_NULL;
+    rt_uint32_t i;
+
+    for (i = 0; i < RT_SCCB_RATES; i++)
+    {
+        if (ops->rates[i].used && ops->rates[i].addr == addr)
+            return &ops->rates[i];
+        if (!ops->rates[i].used && free == RT_NULL)
+            free = &ops->rates[i];
+    }
+
+    return free;
+}
+
+/* every pattern written and read back intact at the current rate */
+static rt_bool_t calib_pass(struct rt_sccb_bus_device *bus, rt_uint16_t addr, rt_uint8_t reg)
+{
+    rt_uint32_t round, i;
+    rt_uint8_t val;
+
+    for (round = 0; round < CALIB_ROUNDS; round++)
+    {
+        for (i = 0; i < sizeof(calib_pattern); i++)
+        {
+            if (rt_sccb_write_reg(bus, addr, reg, calib_pattern[i]) != RT_EOK)
+                return RT_FALSE;
+            if (rt_sccb_read_reg(bus, addr, reg, &val) != RT_EOK)
+                return RT_FALSE;
+            if (val != calib_pattern[i])
+                return RT_FALSE;
+        }
+    }
+
+    return RT_TRUE;
+}
+
+/**
+ * This function finds the fastest timing a device works reliably at. It
+ * sweeps the bus timing down in steps of a quarter, writing patterns to a
+ * scratch register and reading them back, until a step fails. The fastest
+ * passing step plus margin percent is stored for the device address, and
+ * every later transaction with the device runs at it.
+ *
+ * A failing step may corrupt the sub-address and hit another register, so
+ * calibrate right after the device was reset, before it is configured.
+ * Buses of the bit engine (rt_sccb_add_bus()) and waveform buses can be
+ * calibrated. A client timing profile would win over every step, so a
+ * device whose client has one is refused.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg a read/write scratch register, restored afterwards.
+ * @param margin the safety margin in percent of the fastest passing timing.
+ * @param result receives the stored timing. May be RT_NULL.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device fails at the bus timing,
+ *         -RT_EFULL if RT_SCCB_RATES devices are calibrated already,
+ *         -RT_ENOSYS if the bus engine has no rate table, -RT_EBUSY if
+ *         the device's client sets its own timing.
+ */
+rt_err_t rt_sccb_calibrate(struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr,
+                           rt_uint8_t                reg,
+                           rt_uint8_t                margin,
+                           struct rt_sccb_timing     *result)
+{
+    struct rt_sccb_ops *ops;
+    struct rt_sccb_client *client;
+    struct rt_sccb_rate *slot;
+    struct rt_sccb_timing base;
+    rt_uint32_t percent, best = 0;
+    rt_uint8_t saved;
+    rt_err_t ret;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    ops = calib_ops(bus);
+    if (ops == RT_NULL)
+    {
+        LOG_E("SCCB bus engine has no rate table to calibrate");
+
+        return -RT_ENOSYS;
+    }
+
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+
+    client = rt_sccb_client_find(bus, addr);
+    if (client != RT_NULL && client->timing != RT_NULL)
+    {
+        rt_sccb_bus_unlock(bus);
+        LOG_E("device 0x%02x runs at its client timing, not calibrated", addr);
+
+        return -RT_EBUSY;
+    }
+
+    slot = calib_slot(ops, addr);
+    if (slot == RT_NULL)
+    {
+        rt_sccb_bus_unlock(bus);
+        LOG_E("no free rate slot for device 0x%02x", addr);
+
+        return -RT_EFULL;
+    }
+
+    /* the scratch register is saved and restored at the bus timing */
+    slot->used = 0;
+    calib_base(ops, &base);
+    ret = rt_sccb_read_reg(bus, addr, reg, &saved);
+    if (ret != RT_EOK)
+        goto out;
+
+    slot->addr = addr;
+    for (percent = 100; percent >= CALIB_MIN_PERCENT; percent = percent * 3 / 4)
+    {
+        calib_scale(&base, percent, &slot->timing);
+        slot->used = 1;
+        if (!calib_pass(bus, addr, reg))
+            break;
+        best = percent;
+    }
+    slot->used = 0;
+
+    ret = rt_sccb_write_reg(bus, addr, reg, saved);
+    if (ret == RT_EOK && best == 0)
+        ret = -RT_EIO;
+    if (ret != RT_EOK)
+        goto out;
+
+    percent = best * (100 + margin) / 100;
+    if (percent > 100)
+        percent = 100;
+    calib_scale(&base, percent, &slot->timing);
+    slot->used = 1;
+    if (result)
+        *result = slot->timing;
+
+    LOG_D("device 0x%02x passed at %u%%, runs at %u%% of the bus timing",
+          addr, best, percent);
+
+out:
+    rt_sccb_bus_unlock(bus);
+    if (ret != RT_EOK)
+        LOG_E("calibration of device 0x%02x failed", addr);
+
+    return ret;
+}
+
+/**
+ * This function drops the calibrated timing of a device, it runs at the
+ * bus timing again.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ *
+ * @return RT_EOK on success, -RT_ENOSYS if the bus engine has no rate
+ *         table, the error of rt_sccb_bus_lock() otherwise.
+ */
+rt_err_t rt_sccb_calibrate_clear(struct rt_sccb_bus_device *bus, rt_uint16_t addr)
+{
+    struct rt_sccb_ops *ops;
+    rt_uint32_t i;
+    rt_err_t ret;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    ops = calib_ops(bus);
+    if (ops == RT_NULL)
+        return -RT_ENOSYS;
+
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    for (i = 0; i < RT_SCCB_RATES; i++)
+    {
+        if (ops->rates[i].used && ops->rates[i].addr == addr)
+            ops->rates[i].used = 0;
+    }
+    rt_sccb_bus_unlock(bus);
+
+    return RT_EOK;
+}
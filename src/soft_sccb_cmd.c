@@ -0,0 +1,101 @@
+#include <rtthread.h>
+#include "soft_sccb_core.h"
+#include "soft_sccb_trace.h"
+
+#if defined(RT_USING_FINSH) && defined(FINSH_USING_MSH)
+
+static void sccb_hist_dump(const char *name, const rt_uint32_t hist[], rt_uint32_t max_us)
+{
+    rt_uint32_t n;
+
+    rt_kprintf("%s, max %u us\n", name, max_us);
+    for (n = 0; n < RT_SCCB_STATS_BUCKETS; n++)
+    {
+        if (hist[n] == 0)
+            continue;
+        if (n == 0)
+            rt_kprintf("  %8s%-8s us %10u\n", "", "< 1", hist[n]);
+        else if (n == RT_SCCB_STATS_BUCKETS - 1)
+            rt_kprintf("  %8s%-8u us %10u\n", ">= ", 1u << (n - 1), hist[n]);
+        else
+            rt_kprintf("  %8u..%-6u us %10u\n", 1u << (n - 1), (1u << n) - 1, hist[n]);
+    }
+}
+
+static rt_err_t sccb_stats_dump(const char *name, struct rt_sccb_bus_device *bus)
+{
+    struct rt_sccb_bus_stats stats;
+    rt_err_t ret;
+
+    ret = rt_sccb_bus_stats_get(bus, &stats);
+    if (ret != RT_EOK)
+    {
+        rt_kprintf("%s: bus not available (%d)\n", name, (int)ret);
+
+        return ret;
+    }
+    rt_kprintf("%s: xfers %u errors %u msgs %u bytes %u\n", name,
+               stats.xfers, stats.errors, stats.msgs, stats.bytes);
+    rt_kprintf("  nacks %u retries %u stretches %u timeouts %u\n",
+               stats.nacks, stats.retries, stats.stretches, stats.timeouts);
+    rt_kprintf("  locks %u preempts %u\n", stats.locks, stats.preempts);
+    sccb_hist_dump("lock wait", stats.lock_hist, stats.lock_max_us);
+    sccb_hist_dump("transfer", stats.xfer_hist, stats.xfer_max_us);
+
+    return RT_EOK;
+}
+
+static void sccb_trace_out(void *ctx, const char *str)
+{
+    rt_kprintf("%s", str);
+}
+
+static void sccb_usage(void)
+{
+    rt_kprintf("Usage:\n");
+    rt_kprintf("sccb stats <bus>         - show bus statistics\n");
+    rt_kprintf("sccb stats <bus> reset   - clear bus statistics\n");
+    rt_kprintf("sccb trace <bus>         - show the decoded bus trace\n");
+    rt_kprintf("sccb trace <bus> vcd     - dump the bus trace as VCD\n");
+    rt_kprintf("sccb trace <bus> clear   - clear the bus trace\n");
+}
+
+static int sccb(int argc, char **argv)
+{
+    struct rt_sccb_bus_device *bus;
+
+    if (argc < 3)
+    {
+        sccb_usage();
+
+        return -RT_EINVAL;
+    }
+
+    bus = rt_sccb_bus_device_find(argv[2]);
+    if (bus == RT_NULL)
+        return -RT_ERROR;
+
+    if (!rt_strcmp(argv[1], "stats"))
+    {
+        if (argc > 3 && !rt_strcmp(argv[3], "reset"))
+            return rt_sccb_bus_stats_reset(bus);
+
+        return sccb_stats_dump(argv[2], bus);
+    }
+    if (!rt_strcmp(argv[1], "trace"))
+    {
+        if (argc > 3 && !rt_strcmp(argv[3], "clear"))
+            return rt_sccb_trace_clear(bus);
+        if (argc > 3 && !rt_strcmp(argv[3], "vcd"))
+            return rt_sccb_trace_export(bus, RT_SCCB_TRACE_FMT_VCD, sccb_trace_out, RT_NULL);
+
+        return rt_sccb_trace_export(bus, RT_SCCB_TRACE_FMT_LOG, sccb_trace_out, RT_NULL);
+    }
+
+    sccb_usage();
+
+    return -RT_EINVAL;
+}
+MSH_CMD_EXPORT(sccb, SCCB bus tools);
+
+#endif /* RT_USING_FINSH && FINSH_USING_MSH */
@@ -9,6 +9,7 @@
  */
 
 #include <rtthread.h>
+#include <rthw.h>
 #include "soft_sccb_core.h"
 #include "soft_sccb_dev.h"
 
@@ -20,12 +21,21 @@
 #endif
 #include <rtdbg.h>
 
+#define WINDOW_BATCH          16      /* messages per transfer of a register window */
+#define WAIT_SPINS            4       /* back-to-back polls before rt_sccb_wait_reg() sleeps */
+#define WAIT_SLEEP_MAX        (RT_TICK_PER_SECOND / 20)
+#define US_PER_TICK           (1000000 / RT_TICK_PER_SECOND)
+
 rt_err_t rt_sccb_bus_device_register(struct rt_sccb_bus_device *bus,
                                     const char               *bus_name)
 {
     rt_err_t res = RT_EOK;
 
-    rt_mutex_init(&bus->lock, "sccb_bus_lock", RT_IPC_FLAG_FIFO);
+    rt_list_init(&bus->waiters);
+    bus->owner = RT_NULL;
+    bus->nest  = 0;
+    rt_memset(&bus->stats, 0, sizeof(bus->stats));
+    rt_list_init(&bus->clients);
 
     if (bus->timeout == 0) bus->timeout = RT_TICK_PER_SECOND;
 
@@ -40,7 +50,7 @@ struct rt_sccb_bus_device *rt_sccb_bus_device_find(const char *bus_name)
 {
     struct rt_sccb_bus_device *bus;
     rt_device_t dev = rt_device_find(bus_name);
-    if (dev == RT_NULL || dev->type != RT_Device_Class_I2CBUS)
+    if (dev == RT_NULL || dev->type != RT_Device_Class_SCCB)
     {
         LOG_E("SCCB bus %s not exist", bus_name);
 
@@ -52,22 +62,346 @@ struct rt_sccb_bus_device *rt_sccb_bus_device_find(const char *bus_name)
     return bus;
 }
 
+/**
+ * This function returns a free running microsecond timestamp for the bus
+ * statistics. The default has tick resolution, a port can provide a finer
+ * one.
+ *
+ * @return the timestamp in microseconds.
+ */
+RT_WEAK rt_uint32_t rt_sccb_get_us(void)
+{
+    return rt_tick_get() * (1000000 / RT_TICK_PER_SECOND);
+}
+
+static void sccb_stats_hist(rt_uint32_t hist[], rt_uint32_t *max, rt_uint32_t us)
+{
+    rt_uint32_t n = 0;
+
+    while (us >> n && n < RT_SCCB_STATS_BUCKETS - 1)
+        n++;
+    hist[n]++;
+    if (us > *max)
+        *max = us;
+}
+
+/* RT_TRUE if a is more urgent than b */
+static rt_bool_t sccb_key_before(const struct rt_sccb_bus_key *a,
+                                 const struct rt_sccb_bus_key *b)
+{
+    if (a->timed && b->timed)
+        return (rt_int32_t)(a->deadline_us - b->deadline_us) < 0;
+    if (a->timed != b->timed)
+        return a->timed;
+
+    return a->priority < b->priority;
+}
+
+/* behind every waiter at least as urgent, called with interrupts off */
+static void sccb_waiter_insert(struct rt_sccb_bus_device *bus,
+                               struct rt_sccb_bus_waiter *waiter)
+{
+    rt_list_t *node;
+
+    for (node = bus->waiters.next; node != &bus->waiters; node = node->next)
+    {
+        if (sccb_key_before(&waiter->key,
+                            &rt_list_entry(node, struct rt_sccb_bus_waiter, list)->key))
+            break;
+    }
+    rt_list_insert_before(node, &waiter->list);
+}
+
+/*
+ * the owner runs at the priority of its most urgent waiter so a middle
+ * priority thread cannot stall the session a high priority one waits on.
+ * Both helpers are called with interrupts off.
+ */
+static void sccb_owner_lend(struct rt_sccb_bus_device *bus, rt_uint8_t priority)
+{
+    if (priority < bus->owner->current_priority)
+        rt_thread_control(bus->owner, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+}
+
+static void sccb_owner_restore(struct rt_sccb_bus_device *bus)
+{
+    if (bus->owner->current_priority != bus->owner_prio)
+        rt_thread_control(bus->owner, RT_THREAD_CTRL_CHANGE_PRIORITY, &bus->owner_prio);
+}
+
+/* called with interrupts off */
+static void sccb_grant(struct rt_sccb_bus_device    *bus,
+                       rt_thread_t                  thread,
+                       rt_uint32_t                  nest,
+                       const struct rt_sccb_bus_key *key)
+{
+    bus->owner      = thread;
+    bus->owner_prio = thread->current_priority;
+    bus->nest       = nest;
+    bus->key        = *key;
+    bus->stats.locks++;
+}
+
+/*
+ * pass the bus to the head waiter and wake it up, called with interrupts
+ * off, turns them back on.
+ */
+static void sccb_handover(struct rt_sccb_bus_device *bus, rt_base_t level)
+{
+    struct rt_sccb_bus_waiter *next;
+    rt_thread_t thread;
+    rt_list_t *node;
+
+    sccb_owner_restore(bus);
+
+    next = rt_list_entry(bus->waiters.next, struct rt_sccb_bus_waiter, list);
+    rt_list_remove(&next->list);
+    thread = next->thread;
+    sccb_grant(bus, thread, next->nest, &next->key);
+
+    /* the queue is in key order, not thread priority order */
+    for (node = bus->waiters.next; node != &bus->waiters; node = node->next)
+    {
+        next = rt_list_entry(node, struct rt_sccb_bus_waiter, list);
+        sccb_owner_lend(bus, next->thread->current_priority);
+    }
+    rt_hw_interrupt_enable(level);
+
+    /* next lives on the stack of the woken thread, do not touch it after this */
+    rt_thread_resume(thread);
+    rt_schedule();
+}
+
+/*
+ * queue the caller and sleep until the bus is granted, called with
+ * interrupts off, turns them back on. The waiter must already be queued
+ * when the caller is the owner handing the bus away.
+ */
+static void sccb_wait_grant(struct rt_sccb_bus_device *bus,
+                            struct rt_sccb_bus_waiter *waiter,
+                            rt_base_t                 level)
+{
+    rt_thread_suspend(waiter->thread);
+    if (bus->owner == waiter->thread)
+    {
+        sccb_handover(bus, level);
+    }
+    else
+    {
+        sccb_waiter_insert(bus, waiter);
+        sccb_owner_lend(bus, waiter->thread->current_priority);
+        rt_hw_interrupt_enable(level);
+        rt_schedule();
+    }
+
+    /* only a handover resumes a queued thread, but do not trust a wakeup */
+    level = rt_hw_interrupt_disable();
+    while (bus->owner != waiter->thread)
+    {
+        rt_thread_suspend(waiter->thread);
+        rt_hw_interrupt_enable(level);
+        rt_schedule();
+        level = rt_hw_interrupt_disable();
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static rt_err_t sccb_bus_acquire(struct rt_sccb_bus_device    *bus,
+                                 const struct rt_sccb_bus_key *key)
+{
+    rt_thread_t self = rt_thread_self();
+    struct rt_sccb_bus_waiter waiter;
+    rt_base_t level;
+
+    /* only the owner itself ever sets owner to self, no race on this test */
+    if (bus->owner == self)
+    {
+        bus->nest++;
+
+        return RT_EOK;
+    }
+
+    level = rt_hw_interrupt_disable();
+    if (bus->owner == RT_NULL)
+    {
+        sccb_grant(bus, self, 1, key);
+        rt_hw_interrupt_enable(level);
+
+        return RT_EOK;
+    }
+    if (bus->flags & RT_SCCB_BUS_F_SINGLE_CLIENT)
+    {
+        rt_hw_interrupt_enable(level);
+        LOG_E("SCCB single-client bus used by a second thread");
+
+        return -RT_EBUSY;
+    }
+
+    /* contended, queue up and wait for the owner to hand the bus over */
+    waiter.thread = self;
+    waiter.nest   = 1;
+    waiter.key    = *key;
+    sccb_wait_grant(bus, &waiter, level);
+
+    return RT_EOK;
+}
+
+/**
+ * This function takes the bus for the calling thread. Sessions nest, and
+ * every transfer made by the owner inside a session skips the arbitration.
+ * Contending threads queue by thread priority instead of arrival, behind
+ * any rt_sccb_bus_lock_until() callers. With RT_SCCB_BUS_F_SINGLE_CLIENT
+ * only the owner is checked and nothing is queued.
+ *
+ * @param bus the SCCB bus.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if a single-client bus is held by
+ *         another thread.
+ */
+rt_err_t rt_sccb_bus_lock(struct rt_sccb_bus_device *bus)
+{
+    struct rt_sccb_bus_key key;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    key.deadline_us = 0;
+    key.timed       = 0;
+    key.priority    = rt_thread_self()->current_priority;
+
+    return sccb_bus_acquire(bus, &key);
+}
+
+/**
+ * This function takes the bus like rt_sccb_bus_lock(), for work that has
+ * to be on the wire by a deadline, e.g. an exposure update due before the
+ * next frame. Deadline sessions are granted earliest deadline first, ahead
+ * of every priority-ordered waiter. The deadline only orders the queue, a
+ * late grant is not an error.
+ *
+ * @param bus the SCCB bus.
+ * @param deadline_us the deadline on the rt_sccb_get_us() clock.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if a single-client bus is held by
+ *         another thread.
+ */
+rt_err_t rt_sccb_bus_lock_until(struct rt_sccb_bus_device *bus,
+                                rt_uint32_t               deadline_us)
+{
+    struct rt_sccb_bus_key key;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    key.deadline_us = deadline_us;
+    key.timed       = 1;
+    key.priority    = rt_thread_self()->current_priority;
+
+    return sccb_bus_acquire(bus, &key);
+}
+
+/**
+ * This function is a preemption point for long batches, called between
+ * transactions. If a more urgent thread waits for the bus, the session is
+ * handed over and the caller queues again with its own key, resuming once
+ * the urgent work is done. A session opened around the batch by the caller
+ * (lock depth above 1) is never preempted.
+ *
+ * @param bus the SCCB bus, held by the caller.
+ *
+ * @return RT_TRUE if another thread had the bus meanwhile.
+ */
+rt_bool_t rt_sccb_bus_yield(struct rt_sccb_bus_device *bus)
+{
+    struct rt_sccb_bus_waiter waiter;
+    rt_base_t level;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(bus->owner == rt_thread_self());
+
+    if (bus->nest != 1 || (bus->flags & RT_SCCB_BUS_F_SINGLE_CLIENT))
+        return RT_FALSE;
+
+    /* waiters only join the queue, its head can only get more urgent */
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&bus->waiters) ||
+        !sccb_key_before(&rt_list_entry(bus->waiters.next,
+                                        struct rt_sccb_bus_waiter, list)->key,
+                         &bus->key))
+    {
+        rt_hw_interrupt_enable(level);
+
+        return RT_FALSE;
+    }
+
+    waiter.thread = bus->owner;
+    waiter.nest   = bus->nest;
+    waiter.key    = bus->key;
+    bus->stats.preempts++;
+    sccb_waiter_insert(bus, &waiter);
+    sccb_wait_grant(bus, &waiter, level);
+
+    return RT_TRUE;
+}
+
+/**
+ * This function ends a bus session started by rt_sccb_bus_lock(), handing
+ * the bus to the most urgent waiter if there is one.
+ *
+ * @param bus the SCCB bus.
+ */
+void rt_sccb_bus_unlock(struct rt_sccb_bus_device *bus)
+{
+    rt_base_t level;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(bus->owner == rt_thread_self());
+
+    if (--bus->nest)
+        return;
+
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&bus->waiters))
+    {
+        sccb_owner_restore(bus);
+        bus->owner = RT_NULL;
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+    sccb_handover(bus, level);
+}
+
 rt_size_t rt_sccb_transfer(struct rt_sccb_bus_device *bus,
-                          struct rt_sccb_msg         *msg)
+                          struct rt_sccb_msg         msgs[],
+                          rt_uint32_t                num)
 {
+    rt_uint32_t t0, t1, t2;
     rt_size_t ret;
 
     if (bus->ops->master_xfer)
     {
 #ifdef RT_SCCB_DEBUG
-        LOG_D("msg %c, addr=0x%02x, data=%d",
-              (msg.flags & RT_I2C_RD) ? 'R' : 'W',
-              msg.addr, msg.data);
+        for (ret = 0; ret < num; ret++)
+        {
+            LOG_D("msgs[%d] %c, addr=0x%02x, reg=0x%02x", ret,
+                  (msgs[ret].flags & RT_SCCB_RD) ? 'R' : 'W',
+                  msgs[ret].addr, msgs[ret].reg);
+        }
 #endif
 
-        rt_mutex_take(&bus->lock, RT_WAITING_FOREVER);
-        ret = bus->ops->master_xfer(bus, msg);
-        rt_mutex_release(&bus->lock);
+        t0 = rt_sccb_get_us();
+        if (rt_sccb_bus_lock(bus) != RT_EOK)
+            return 0;
+        t1 = rt_sccb_get_us();
+        ret = bus->ops->master_xfer(bus, msgs, num);
+        t2 = rt_sccb_get_us();
+
+        bus->stats.xfers++;
+        bus->stats.msgs += ret;
+        if (ret != num)
+            bus->stats.errors++;
+        sccb_stats_hist(bus->stats.lock_hist, &bus->stats.lock_max_us, t1 - t0);
+        sccb_stats_hist(bus->stats.xfer_hist, &bus->stats.xfer_max_us, t2 - t1);
+        rt_sccb_bus_unlock(bus);
 
         return ret;
     }
@@ -89,9 +423,11 @@ rt_size_t rt_sccb_master_send(struct rt_sccb_bus_device *bus,
 
     msg.addr  = addr;
     msg.flags = flags;
-    msg.data   = data;
+    msg.reg   = 0;
+    msg.len   = 1;
+    msg.data  = data;
 
-    ret = rt_sccb_transfer(bus, &msg);
+    ret = rt_sccb_transfer(bus, &msg, 1);
 
     return ret;
 }
@@ -107,13 +443,521 @@ rt_size_t rt_sccb_master_recv(struct rt_sccb_bus_device *bus,
 
     msg.addr   = addr;
     msg.flags  = flags | RT_SCCB_RD;
-    msg.data    = data;
+    msg.reg    = 0;
+    msg.len    = 1;
+    msg.data   = data;
 
-    ret = rt_sccb_transfer(bus, &msg);
+    ret = rt_sccb_transfer(bus, &msg, 1);
 
     return ret;
 }
 
+/**
+ * This function writes one register as a single 3-phase write transaction
+ * (ID, sub-address, data).
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param val the value to write.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_write_reg(struct rt_sccb_bus_device *bus,
+                           rt_uint16_t               addr,
+                           rt_uint8_t                reg,
+                           rt_uint8_t                val)
+{
+    struct rt_sccb_msg msg;
+    RT_ASSERT(bus != RT_NULL);
+
+    msg.addr  = addr;
+    msg.flags = RT_SCCB_WR | RT_SCCB_REG;
+    msg.reg   = reg;
+    msg.len   = 1;
+    msg.data  = &val;
+
+    return (rt_sccb_transfer(bus, &msg, 1) == 1) ? RT_EOK : -RT_EIO;
+}
+
+/**
+ * This function reads one register with a 2-phase write (ID, sub-address)
+ * followed by a 2-phase read (ID, data), both under one bus lock hold.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param val the buffer receiving the register value.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_read_reg(struct rt_sccb_bus_device *bus,
+                          rt_uint16_t               addr,
+                          rt_uint8_t                reg,
+                          rt_uint8_t                *val)
+{
+    struct rt_sccb_msg msg[2];
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(val != RT_NULL);
+
+    msg[0].addr  = addr;
+    msg[0].flags = RT_SCCB_WR | RT_SCCB_REG;
+    msg[0].reg   = reg;
+    msg[0].len   = 0;
+    msg[0].data  = RT_NULL;
+
+    msg[1].addr  = addr;
+    msg[1].flags = RT_SCCB_RD;
+    msg[1].reg   = 0;
+    msg[1].len   = 1;
+    msg[1].data  = val;
+
+    return (rt_sccb_transfer(bus, msg, 2) == 2) ? RT_EOK : -RT_EIO;
+}
+
+/**
+ * This function writes len consecutive registers as one sequential write
+ * transaction (ID, sub-address, data bytes). The device increments the
+ * sub-address after each byte.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param flags RT_SCCB_REG16 for a 16-bit sub-address, else 0.
+ * @param reg the first register sub-address.
+ * @param data the values to write.
+ * @param len the number of bytes, at least 1.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_write_burst(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint16_t               flags,
+                             rt_uint16_t               reg,
+                             const rt_uint8_t          *data,
+                             rt_uint16_t               len)
+{
+    struct rt_sccb_msg msg;
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(data != RT_NULL);
+    RT_ASSERT(len > 0);
+
+    msg.addr  = addr;
+    msg.flags = RT_SCCB_WR | RT_SCCB_REG | RT_SCCB_BURST | (flags & RT_SCCB_REG16);
+    msg.reg   = reg;
+    msg.len   = len;
+    msg.data  = (rt_uint8_t *)data;
+
+    return (rt_sccb_transfer(bus, &msg, 1) == 1) ? RT_EOK : -RT_EIO;
+}
+
+/**
+ * This function reads len consecutive registers with a 2-phase write of the
+ * first sub-address followed by one sequential read, the master ACKing every
+ * byte but the last.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param flags RT_SCCB_REG16 for a 16-bit sub-address, else 0.
+ * @param reg the first register sub-address.
+ * @param data the buffer receiving the values.
+ * @param len the number of bytes, at least 1.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_read_burst(struct rt_sccb_bus_device *bus,
+                            rt_uint16_t               addr,
+                            rt_uint16_t               flags,
+                            rt_uint16_t               reg,
+                            rt_uint8_t                *data,
+                            rt_uint16_t               len)
+{
+    struct rt_sccb_msg msg[2];
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(data != RT_NULL);
+    RT_ASSERT(len > 0);
+
+    msg[0].addr  = addr;
+    msg[0].flags = RT_SCCB_WR | RT_SCCB_REG | (flags & RT_SCCB_REG16);
+    msg[0].reg   = reg;
+    msg[0].len   = 0;
+    msg[0].data  = RT_NULL;
+
+    msg[1].addr  = addr;
+    msg[1].flags = RT_SCCB_RD | RT_SCCB_BURST;
+    msg[1].reg   = 0;
+    msg[1].len   = len;
+    msg[1].data  = data;
+
+    return (rt_sccb_transfer(bus, msg, 2) == 2) ? RT_EOK : -RT_EIO;
+}
+
+/**
+ * This function attaches a client to its bus. From then on the bus runs
+ * every transaction with client_addr at the client's timing, retries and
+ * stretch timeout, switching at the start condition. bus and client_addr
+ * must be filled in, unset profile fields keep the bus settings.
+ *
+ * @param client the SCCB client.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if another client has the address.
+ */
+rt_err_t rt_sccb_client_attach(struct rt_sccb_client *client)
+{
+    struct rt_sccb_bus_device *bus;
+    rt_err_t ret;
+
+    RT_ASSERT(client != RT_NULL);
+    RT_ASSERT(client->bus != RT_NULL);
+
+    bus = client->bus;
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    if (rt_sccb_client_find(bus, client->client_addr) != RT_NULL)
+    {
+        LOG_E("SCCB device 0x%02x already has a client", client->client_addr);
+        ret = -RT_EBUSY;
+    }
+    else
+    {
+        rt_list_insert_before(&bus->clients, &client->list);
+    }
+    rt_sccb_bus_unlock(bus);
+
+    return ret;
+}
+
+/**
+ * This function detaches a client, its device runs at the bus settings
+ * again.
+ *
+ * @param client the SCCB client.
+ */
+void rt_sccb_client_detach(struct rt_sccb_client *client)
+{
+    RT_ASSERT(client != RT_NULL);
+
+    if (rt_sccb_bus_lock(client->bus) != RT_EOK)
+        return;
+    rt_list_remove(&client->list);
+    rt_list_init(&client->list);
+    rt_sccb_bus_unlock(client->bus);
+}
+
+/**
+ * This function looks up the client attached for a device address. The
+ * caller holds the bus lock.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ *
+ * @return the client, RT_NULL if the device has none.
+ */
+struct rt_sccb_client *rt_sccb_client_find(struct rt_sccb_bus_device *bus,
+                                           rt_uint16_t               addr)
+{
+    struct rt_sccb_client *client;
+    rt_list_t *node;
+
+    for (node = bus->clients.next; node != &bus->clients; node = node->next)
+    {
+        client = rt_list_entry(node, struct rt_sccb_client, list);
+        if (client->client_addr == addr)
+            return client;
+    }
+
+    return RT_NULL;
+}
+
+/**
+ * This function writes count sequential registers, one 3-phase write each,
+ * in message batches under one bus lock hold. More urgent bus users may
+ * slip in between batches, see rt_sccb_bus_yield().
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the first register sub-address.
+ * @param vals the values, vals[n] for register reg + n.
+ * @param count the number of registers, the window ends at register 0xff.
+ *
+ * @return the number of registers written.
+ */
+rt_size_t rt_sccb_write_regs(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint8_t                reg,
+                             const rt_uint8_t          *vals,
+                             rt_size_t                 count)
+{
+    struct rt_sccb_msg msgs[WINDOW_BATCH];
+    rt_size_t done = 0, num, n, i;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(vals != RT_NULL);
+
+    if (count > 0x100u - reg)
+        count = 0x100u - reg;
+    if (rt_sccb_bus_lock(bus) != RT_EOK)
+        return 0;
+    while (done < count)
+    {
+        num = count - done < WINDOW_BATCH ? count - done : WINDOW_BATCH;
+        for (i = 0; i < num; i++)
+        {
+            msgs[i].addr  = addr;
+            msgs[i].flags = RT_SCCB_WR | RT_SCCB_REG;
+            msgs[i].reg   = reg + done + i;
+            msgs[i].len   = 1;
+            msgs[i].data  = (rt_uint8_t *)&vals[done + i];
+        }
+        n = rt_sccb_transfer(bus, msgs, num);
+        done += n;
+        if (n != num)
+            break;
+        rt_sccb_bus_yield(bus);
+    }
+    rt_sccb_bus_unlock(bus);
+
+    return done;
+}
+
+/**
+ * This function reads count sequential registers, each a 2-phase write
+ * followed by a 2-phase read, in message batches under one bus lock hold.
+ * More urgent bus users may slip in between batches.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the first register sub-address.
+ * @param vals the buffer receiving the values, vals[n] for register reg + n.
+ * @param count the number of registers, the window ends at register 0xff.
+ *
+ * @return the number of registers read.
+ */
+rt_size_t rt_sccb_read_regs(struct rt_sccb_bus_device *bus,
+                            rt_uint16_t               addr,
+                            rt_uint8_t                reg,
+                            rt_uint8_t                *vals,
+                            rt_size_t                 count)
+{
+    struct rt_sccb_msg msgs[WINDOW_BATCH];
+    rt_size_t done = 0, num, n, i;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(vals != RT_NULL);
+
+    if (count > 0x100u - reg)
+        count = 0x100u - reg;
+    if (rt_sccb_bus_lock(bus) != RT_EOK)
+        return 0;
+    while (done < count)
+    {
+        num = count - done < WINDOW_BATCH / 2 ? count - done : WINDOW_BATCH / 2;
+        for (i = 0; i < num; i++)
+        {
+            msgs[2 * i].addr      = addr;
+            msgs[2 * i].flags     = RT_SCCB_WR | RT_SCCB_REG;
+            msgs[2 * i].reg       = reg + done + i;
+            msgs[2 * i].len       = 0;
+            msgs[2 * i].data      = RT_NULL;
+            msgs[2 * i + 1].addr  = addr;
+            msgs[2 * i + 1].flags = RT_SCCB_RD;
+            msgs[2 * i + 1].reg   = 0;
+            msgs[2 * i + 1].len   = 1;
+            msgs[2 * i + 1].data  = &vals[done + i];
+        }
+        n = rt_sccb_transfer(bus, msgs, 2 * num) / 2;
+        done += n;
+        if (n != num)
+            break;
+        rt_sccb_bus_yield(bus);
+    }
+    rt_sccb_bus_unlock(bus);
+
+    return done;
+}
+
+/**
+ * This function updates a bit field of one register. The read and the
+ * write are done under one bus lock hold, so no other transaction can
+ * interleave, and the write is skipped when the field already holds val.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param mask the bits to update.
+ * @param val the new value of the masked bits.
+ * @param changed set to RT_TRUE if the register was written. May be RT_NULL.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_update_bits_check(struct rt_sccb_bus_device *bus,
+                                   rt_uint16_t               addr,
+                                   rt_uint8_t                reg,
+                                   rt_uint8_t                mask,
+                                   rt_uint8_t                val,
+                                   rt_bool_t                 *changed)
+{
+    rt_uint8_t cur, tmp;
+    rt_err_t ret;
+    RT_ASSERT(bus != RT_NULL);
+
+    if (changed)
+        *changed = RT_FALSE;
+
+    /* read_reg and write_reg nest inside this session */
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    ret = rt_sccb_read_reg(bus, addr, reg, &cur);
+    if (ret == RT_EOK)
+    {
+        tmp = (cur & ~mask) | (val & mask);
+        if (tmp != cur)
+        {
+            ret = rt_sccb_write_reg(bus, addr, reg, tmp);
+            if (ret == RT_EOK && changed)
+                *changed = RT_TRUE;
+        }
+    }
+    rt_sccb_bus_unlock(bus);
+
+    return ret;
+}
+
+/**
+ * This function updates a bit field of one register atomically, see
+ * rt_sccb_update_bits_check().
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param mask the bits to update.
+ * @param val the new value of the masked bits.
+ *
+ * @return RT_EOK on success, -RT_EIO if the device did not respond.
+ */
+rt_err_t rt_sccb_update_bits(struct rt_sccb_bus_device *bus,
+                             rt_uint16_t               addr,
+                             rt_uint8_t                reg,
+                             rt_uint8_t                mask,
+                             rt_uint8_t                val)
+{
+    return rt_sccb_update_bits_check(bus, addr, reg, mask, val, RT_NULL);
+}
+
+/**
+ * This function polls a register until (value & mask) == val, e.g. a reset
+ * or mode switch completing. The first polls follow each other directly,
+ * then the sleeps between them double up to WAIT_SLEEP_MAX ticks. The bus
+ * is released between polls unless the caller holds a session. A device
+ * that does not answer meanwhile, as some do during a reset, is polled on.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param reg the register sub-address.
+ * @param mask the bits to test.
+ * @param val the expected value of the masked bits.
+ * @param timeout_us how long to wait.
+ * @param elapsed_us the time until the condition held or the wait gave up.
+ *        May be RT_NULL.
+ *
+ * @return RT_EOK when the condition holds, -RT_ETIMEOUT if it did not in
+ *         time, -RT_EIO if the device did not respond to the last poll.
+ */
+rt_err_t rt_sccb_wait_reg(struct rt_sccb_bus_device *bus,
+                          rt_uint16_t               addr,
+                          rt_uint8_t                reg,
+                          rt_uint8_t                mask,
+                          rt_uint8_t                val,
+                          rt_uint32_t               timeout_us,
+                          rt_uint32_t               *elapsed_us)
+{
+    rt_uint32_t start, elapsed, left, polls = 0;
+    rt_tick_t sleep = 1, ticks;
+    rt_uint8_t cur;
+    rt_err_t ret;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    start = rt_sccb_get_us();
+    while (1)
+    {
+        ret = rt_sccb_read_reg(bus, addr, reg, &cur);
+        elapsed = rt_sccb_get_us() - start;
+        if (ret == RT_EOK && (cur & mask) == val)
+            break;
+        if (elapsed >= timeout_us)
+        {
+            if (ret == RT_EOK)
+                ret = -RT_ETIMEOUT;
+            break;
+        }
+
+        /* an unlock hands the bus to any waiter, so even tight polls share it */
+        if (++polls <= WAIT_SPINS)
+            continue;
+
+        left  = timeout_us - elapsed;
+        ticks = (left + US_PER_TICK - 1) / US_PER_TICK;
+        rt_thread_delay(sleep < ticks ? sleep : ticks);
+        if (sleep < WAIT_SLEEP_MAX)
+            sleep <<= 1;
+    }
+
+    if (elapsed_us)
+        *elapsed_us = elapsed;
+
+    return ret;
+}
+
+/**
+ * This function takes a consistent snapshot of the bus statistics.
+ *
+ * @param bus the SCCB bus.
+ * @param stats the buffer receiving the statistics.
+ *
+ * @return RT_EOK on success, the error of rt_sccb_bus_lock() otherwise, in
+ *         which case stats is left untouched.
+ */
+rt_err_t rt_sccb_bus_stats_get(struct rt_sccb_bus_device *bus,
+                               struct rt_sccb_bus_stats  *stats)
+{
+    rt_err_t ret;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(stats != RT_NULL);
+
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    rt_memcpy(stats, &bus->stats, sizeof(*stats));
+    rt_sccb_bus_unlock(bus);
+
+    return RT_EOK;
+}
+
+/**
+ * This function clears the bus statistics.
+ *
+ * @param bus the SCCB bus.
+ *
+ * @return RT_EOK on success, the error of rt_sccb_bus_lock() otherwise.
+ */
+rt_err_t rt_sccb_bus_stats_reset(struct rt_sccb_bus_device *bus)
+{
+    rt_err_t ret;
+
+    RT_ASSERT(bus != RT_NULL);
+
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    rt_memset(&bus->stats, 0, sizeof(bus->stats));
+    rt_sccb_bus_unlock(bus);
+
+    return RT_EOK;
+}
+
 int rt_sccb_core_init(void)
 {
     return 0;
@@ -1,6 +1,7 @@
 #include <rtthread.h>
 #include "soft_sccb_dev.h"
 #include "soft_sccb_core.h"
+#include "soft_sccb_trace.h"
 
 #define DBG_TAG               "SCCB"
 #ifdef RT_SCCB_DEBUG
@@ -10,25 +11,28 @@
 #endif
 #include <rtdbg.h>
 
+/*
+ * rt_device_read()/rt_device_write() move a register window: pos is the
+ * first register and count the number of registers, of the device set with
+ * RT_SCCB_DEV_CTRL_ADDR. Raw messages go through RT_SCCB_DEV_CTRL_RW.
+ */
 static rt_size_t sccb_bus_device_read(rt_device_t dev,
                                      rt_off_t    pos,
                                      void       *buffer,
                                      rt_size_t   count)
 {
-    rt_uint16_t addr;
-    rt_uint16_t flags;
     struct rt_sccb_bus_device *bus = (struct rt_sccb_bus_device *)dev->user_data;
 
     RT_ASSERT(bus != RT_NULL);
     RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(count != 1);
 
-    LOG_D("SCCB bus dev [%s] reading %u bytes.", dev->parent.name, count);
+    LOG_D("SCCB bus dev [%s] reading %u registers from 0x%02x.",
+          dev->parent.name, count, pos);
 
-    addr = pos & 0xffff;
-    flags = (pos >> 16) & 0xffff;
+    if (pos < 0 || pos > 0xff)
+        return 0;
 
-    return rt_sccb_master_recv(bus, addr, flags, (rt_uint8_t *)buffer);
+    return rt_sccb_read_regs(bus, bus->addr, pos, (rt_uint8_t *)buffer, count);
 }
 
 static rt_size_t sccb_bus_device_write(rt_device_t dev,
@@ -36,27 +40,27 @@ static rt_size_t sccb_bus_device_write(rt_device_t dev,
                                       const void *buffer,
                                       rt_size_t   count)
 {
-    rt_uint16_t addr;
-    rt_uint16_t flags;
     struct rt_sccb_bus_device *bus = (struct rt_sccb_bus_device *)dev->user_data;
 
     RT_ASSERT(bus != RT_NULL);
     RT_ASSERT(buffer != RT_NULL);
 
-    LOG_D("SCCB bus dev [%s] writing %u bytes.", dev->parent.name, count);
+    LOG_D("SCCB bus dev [%s] writing %u registers from 0x%02x.",
+          dev->parent.name, count, pos);
 
-    addr = pos & 0xffff;
-    flags = (pos >> 16) & 0xffff;
+    if (pos < 0 || pos > 0xff)
+        return 0;
 
-    return rt_sccb_master_send(bus, addr, flags, (rt_uint8_t *)buffer);
+    return rt_sccb_write_regs(bus, bus->addr, pos, (const rt_uint8_t *)buffer, count);
 }
 
 static rt_err_t sccb_bus_device_control(rt_device_t dev,
                                        int         cmd,
                                        void       *args)
 {
-    rt_err_t ret;
+    rt_size_t ret;
     struct rt_sccb_priv_data *priv_data;
+    struct rt_sccb_trace_export *export;
     struct rt_sccb_bus_device *bus = (struct rt_sccb_bus_device *)dev->user_data;
 
     RT_ASSERT(bus != RT_NULL);
@@ -71,12 +75,24 @@ static rt_err_t sccb_bus_device_control(rt_device_t dev,
         break;
     case RT_SCCB_DEV_CTRL_RW:
         priv_data = (struct rt_sccb_priv_data *)args;
-        ret = rt_sccb_transfer(bus, priv_data->msg);
-        if (ret < 0)
+        ret = rt_sccb_transfer(bus, priv_data->msgs, priv_data->number);
+        if (ret != priv_data->number)
         {
             return -RT_EIO;
         }
         break;
+    case RT_SCCB_DEV_CTRL_STATS:
+        return rt_sccb_bus_stats_get(bus, (struct rt_sccb_bus_stats *)args);
+    case RT_SCCB_DEV_CTRL_STATS_RESET:
+        return rt_sccb_bus_stats_reset(bus);
+    case RT_SCCB_DEV_CTRL_TRACE:
+        export = (struct rt_sccb_trace_export *)args;
+        return rt_sccb_trace_export(bus, export->format, export->out, export->ctx);
+    case RT_SCCB_DEV_CTRL_TRACE_CLEAR:
+        return rt_sccb_trace_clear(bus);
+    case RT_SCCB_DEV_CTRL_RETRIES:
+        bus->retries = *(rt_int32_t *)args;
+        break;
     default:
         break;
     }
@@ -124,3 +140,138 @@ rt_err_t rt_sccb_bus_device_device_init(struct rt_sccb_bus_device *bus, const ch
 
     return RT_EOK;
 }
+
+/* a client device is the register window of one device on a bus */
+static rt_size_t sccb_client_device_read(rt_device_t dev,
+                                        rt_off_t    pos,
+                                        void       *buffer,
+                                        rt_size_t   count)
+{
+    struct rt_sccb_client *client = (struct rt_sccb_client *)dev->user_data;
+
+    RT_ASSERT(client != RT_NULL);
+    RT_ASSERT(buffer != RT_NULL);
+
+    if (pos < 0 || pos > 0xff)
+        return 0;
+
+    return rt_sccb_read_regs(client->bus, client->client_addr, pos,
+                             (rt_uint8_t *)buffer, count);
+}
+
+static rt_size_t sccb_client_device_write(rt_device_t dev,
+                                         rt_off_t    pos,
+                                         const void *buffer,
+                                         rt_size_t   count)
+{
+    struct rt_sccb_client *client = (struct rt_sccb_client *)dev->user_data;
+
+    RT_ASSERT(client != RT_NULL);
+    RT_ASSERT(buffer != RT_NULL);
+
+    if (pos < 0 || pos > 0xff)
+        return 0;
+
+    return rt_sccb_write_regs(client->bus, client->client_addr, pos,
+                              (const rt_uint8_t *)buffer, count);
+}
+
+/*
+ * the client's own address and profile. RT_SCCB_DEV_CTRL_TIMEOUT takes the
+ * clock stretch deadline in us here, 0 for the bus setting.
+ */
+static rt_err_t sccb_client_device_control(rt_device_t dev,
+                                          int         cmd,
+                                          void       *args)
+{
+    struct rt_sccb_client *client = (struct rt_sccb_client *)dev->user_data;
+    struct rt_sccb_client *owner;
+    rt_err_t ret;
+
+    RT_ASSERT(client != RT_NULL);
+
+    /* the bus reads the profile at every start condition */
+    ret = rt_sccb_bus_lock(client->bus);
+    if (ret != RT_EOK)
+        return ret;
+
+    switch (cmd)
+    {
+    case RT_SCCB_DEV_CTRL_ADDR:
+        owner = rt_sccb_client_find(client->bus, *(rt_uint16_t *)args);
+        if (owner != RT_NULL && owner != client)
+            ret = -RT_EBUSY;
+        else
+            client->client_addr = *(rt_uint16_t *)args;
+        break;
+    case RT_SCCB_DEV_CTRL_TIMEOUT:
+        client->timeout_us = *(rt_uint32_t *)args;
+        break;
+    case RT_SCCB_DEV_CTRL_TIMING:
+        client->timing = (const struct rt_sccb_timing *)args;
+        break;
+    case RT_SCCB_DEV_CTRL_RETRIES:
+        client->retries = *(rt_int32_t *)args;
+        break;
+    default:
+        ret = -RT_EINVAL;
+        break;
+    }
+    rt_sccb_bus_unlock(client->bus);
+
+    return ret;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops sccb_client_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    sccb_client_device_read,
+    sccb_client_device_write,
+    sccb_client_device_control
+};
+#endif
+
+/**
+ * This function attaches a client to its bus and registers it as a device,
+ * so generic tools can dump or restore the registers of one device with
+ * rt_device_read()/rt_device_write(). bus, client_addr and the profile
+ * fields must be filled in.
+ *
+ * @param client the SCCB client.
+ * @param name the device name.
+ *
+ * @return the error code, RT_EOK on successfully.
+ */
+rt_err_t rt_sccb_client_device_init(struct rt_sccb_client *client, const char *name)
+{
+    struct rt_device *device;
+    rt_err_t ret;
+    RT_ASSERT(client != RT_NULL);
+    RT_ASSERT(client->bus != RT_NULL);
+
+    ret = rt_sccb_client_attach(client);
+    if (ret != RT_EOK)
+        return ret;
+
+    device = &client->parent;
+
+    device->user_data = client;
+
+    /* not RT_Device_Class_SCCB, that class is looked up as a bus */
+    device->type    = RT_Device_Class_Miscellaneous;
+#ifdef RT_USING_DEVICE_OPS
+    device->ops     = &sccb_client_ops;
+#else
+    device->init    = RT_NULL;
+    device->open    = RT_NULL;
+    device->close   = RT_NULL;
+    device->read    = sccb_client_device_read;
+    device->write   = sccb_client_device_write;
+    device->control = sccb_client_device_control;
+#endif
+
+    return rt_device_register(device, name, RT_DEVICE_FLAG_RDWR);
+}
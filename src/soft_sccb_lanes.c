@@ -0,0 +1,392 @@
+#include <rtthread.h>
+#include "soft_sccb.h"
+#include "soft_sccb_lanes.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+/* one bus phase: the profile value when a timing profile is set, else half of delay_us */
+#define PHASE_DELAY(lanes, phase)                                       \
+    lanes_delay(lanes, (lanes)->ops->timing ? (lanes)->ops->timing->phase : 0)
+
+static void lanes_delay(struct rt_sccb_lanes *lanes, rt_uint32_t ns)
+{
+    const struct rt_sccb_lanes_ops *ops = lanes->ops;
+
+    if (!ops->timing)
+        ops->udelay((ops->delay_us + 1) >> 1);
+    else if (ns && ops->ndelay)
+        ops->ndelay(ns);
+    else if (ns)
+        ops->udelay((ns + 999) / 1000);
+}
+
+/* the SDA pins of the lanes in lane_mask */
+static rt_uint32_t lanes_sda(struct rt_sccb_lanes *lanes, rt_uint32_t lane_mask)
+{
+    rt_uint32_t pins = 0;
+    rt_uint8_t i;
+
+    for (i = 0; i < lanes->num; i++)
+    {
+        if (lane_mask & (1u << i))
+            pins |= lanes->sda[i];
+    }
+
+    return pins;
+}
+
+/* one port write for every line that changes level */
+static void lanes_drive(struct rt_sccb_lanes *lanes, rt_uint32_t scl, rt_uint32_t sda)
+{
+    rt_uint32_t values = (scl ? lanes->scl : 0) | (sda & lanes->sda_all);
+    rt_uint32_t change = lanes->port ^ values;
+
+    if (!change)
+        return;
+
+    lanes->ops->set_port(lanes->ops->data, change, values & change);
+    lanes->port = values;
+}
+
+static rt_int32_t lanes_scl_level(void *data)
+{
+    struct rt_sccb_lanes *lanes = (struct rt_sccb_lanes *)data;
+
+    return (lanes->ops->get_port(lanes->ops->data) & lanes->scl) == lanes->scl;
+}
+
+static void lanes_udelay(void *data, rt_uint32_t us)
+{
+    ((struct rt_sccb_lanes *)data)->ops->udelay(us);
+}
+
+/**
+ * release SCL, keeping SDA as it is, and wait until every SCL pin reads
+ * high, with the stretch wait of the bit engine.
+ */
+static rt_err_t lanes_scl_high(struct rt_sccb_lanes *lanes)
+{
+    const struct rt_sccb_lanes_ops *ops = lanes->ops;
+    rt_uint32_t waited;
+
+    lanes_drive(lanes, 1, lanes->port);
+    if (!lanes_scl_level(lanes))
+    {
+        lanes->stretches++;
+        if (rt_sccb_stretch_wait(lanes_scl_level, lanes_udelay, lanes, ops->spin_us,
+                                 ops->timeout_us ? ops->timeout_us : RT_SCCB_LANES_TIMEOUT_US,
+                                 &waited) != RT_EOK)
+        {
+            lanes->stretch_timeouts++;
+
+            return -RT_ETIMEOUT;
+        }
+        lanes->stretch_us = waited;
+        if (waited > lanes->stretch_max_us)
+            lanes->stretch_max_us = waited;
+    }
+    PHASE_DELAY(lanes, scl_high_ns);
+
+    return RT_EOK;
+}
+
+static rt_err_t lanes_start(struct rt_sccb_lanes *lanes, rt_uint32_t sda)
+{
+    lanes_drive(lanes, lanes->port & lanes->scl, lanes->port | sda);
+    if (lanes_scl_high(lanes) != RT_EOK)
+    {
+        LOG_D("lanes_start: wait scl pin high timeout");
+
+        return -RT_ETIMEOUT;
+    }
+    PHASE_DELAY(lanes, su_sto_ns);
+    lanes_drive(lanes, 1, lanes->port & ~sda);
+    PHASE_DELAY(lanes, hd_sta_ns);
+    lanes_drive(lanes, 0, lanes->port);
+
+    return RT_EOK;
+}
+
+static rt_err_t lanes_stop(struct rt_sccb_lanes *lanes, rt_uint32_t sda)
+{
+    lanes_drive(lanes, 0, lanes->port & ~sda);
+    PHASE_DELAY(lanes, scl_low_ns);
+    if (lanes_scl_high(lanes) != RT_EOK)
+    {
+        LOG_D("lanes_stop: wait scl pin high timeout");
+
+        return -RT_ETIMEOUT;
+    }
+    PHASE_DELAY(lanes, su_sto_ns);
+    lanes_drive(lanes, 1, lanes->port | sda);
+    PHASE_DELAY(lanes, scl_low_ns);
+
+    return RT_EOK;
+}
+
+/**
+ * clock one byte out on every lane in active, data[n] going to lane n.
+ * Other lanes keep SDA released.
+ *
+ * @return the lanes that acknowledged the byte.
+ */
+static rt_uint32_t lanes_writeb(struct rt_sccb_lanes *lanes,
+                                rt_uint32_t          active,
+                                const rt_uint8_t     data[])
+{
+    rt_uint32_t all = lanes->sda_all;
+    rt_uint32_t idle = all & ~lanes_sda(lanes, active);
+    rt_uint32_t sda, port, acked = 0;
+    rt_int32_t i;
+    rt_uint8_t n;
+
+    for (i = 7; i >= 0; i--)
+    {
+        sda = idle;
+        for (n = 0; n < lanes->num; n++)
+        {
+            if ((active & (1u << n)) && ((data[n] >> i) & 1))
+                sda |= lanes->sda[n];
+        }
+        /* SCL falls and the next bit goes out in the same port write */
+        lanes_drive(lanes, 0, sda);
+        PHASE_DELAY(lanes, scl_low_ns);
+        if (lanes_scl_high(lanes) != RT_EOK)
+        {
+            LOG_D("lanes_writeb: wait scl pin high timeout at bit %d", i);
+
+            return 0;
+        }
+    }
+
+    lanes_drive(lanes, 0, all);
+    PHASE_DELAY(lanes, scl_low_ns);
+    if (lanes_scl_high(lanes) != RT_EOK)
+        return 0;
+    port = lanes->ops->get_port(lanes->ops->data);
+    lanes_drive(lanes, 0, all);
+
+    for (n = 0; n < lanes->num; n++)
+    {
+        if ((active & (1u << n)) && !(port & lanes->sda[n]))
+            acked |= 1u << n;
+    }
+
+    return acked;
+}
+
+/**
+ * clock one byte in on every lane in active, sampling all of them with one
+ * port read per bit, then send NACK to end the read.
+ *
+ * @return the lanes that were read.
+ */
+static rt_uint32_t lanes_readb(struct rt_sccb_lanes *lanes,
+                               rt_uint32_t          active,
+                               rt_uint8_t           data[])
+{
+    rt_uint32_t all = lanes->sda_all;
+    rt_uint32_t port;
+    rt_uint8_t i, n;
+
+    for (n = 0; n < lanes->num; n++)
+        data[n] = 0;
+
+    lanes_drive(lanes, 0, all);
+    PHASE_DELAY(lanes, scl_low_ns);
+    for (i = 0; i < 8; i++)
+    {
+        if (lanes_scl_high(lanes) != RT_EOK)
+        {
+            LOG_D("lanes_readb: wait scl pin high timeout at bit %d", 7 - i);
+
+            return 0;
+        }
+        port = lanes->ops->get_port(lanes->ops->data);
+        for (n = 0; n < lanes->num; n++)
+            data[n] = (data[n] << 1) | ((port & lanes->sda[n]) ? 1 : 0);
+        lanes_drive(lanes, 0, all);
+        PHASE_DELAY(lanes, scl_low_ns);
+    }
+
+    /* NACK, SDA is still released */
+    if (lanes_scl_high(lanes) != RT_EOK)
+        return 0;
+    lanes_drive(lanes, 0, all);
+    PHASE_DELAY(lanes, scl_low_ns);
+
+    return active;
+}
+
+/**
+ * This function sets up a multi-lane bus and releases every line. ops, sda,
+ * scl and num must be filled in.
+ *
+ * @param lanes the multi-lane bus.
+ * @param name the lock name.
+ *
+ * @return RT_EOK on success.
+ */
+rt_err_t rt_sccb_lanes_init(struct rt_sccb_lanes *lanes, const char *name)
+{
+    const struct rt_sccb_lanes_ops *ops;
+    rt_uint32_t all;
+
+    RT_ASSERT(lanes != RT_NULL);
+    RT_ASSERT(lanes->ops != RT_NULL);
+    RT_ASSERT(lanes->num > 0 && lanes->num <= RT_SCCB_LANES_MAX);
+
+    ops = lanes->ops;
+    lanes->sda_all = lanes_sda(lanes, RT_SCCB_LANES_ALL);
+    all = lanes->sda_all | lanes->scl;
+    ops->set_port(ops->data, all, all);
+    lanes->port = all;
+
+    return rt_mutex_init(&lanes->lock, name, RT_IPC_FLAG_FIFO);
+}
+
+/**
+ * This function writes one register on several lanes in one 3-phase write,
+ * each lane getting its own value.
+ *
+ * @param lanes the multi-lane bus.
+ * @param lane_mask the lanes to write, bit n for lane n.
+ * @param addr the 7-bit device address, the same on every lane.
+ * @param reg the register sub-address.
+ * @param vals the values, vals[n] for lane n.
+ *
+ * @return the lanes that acknowledged the whole transaction.
+ */
+rt_uint32_t rt_sccb_lanes_write_reg(struct rt_sccb_lanes *lanes,
+                                    rt_uint32_t          lane_mask,
+                                    rt_uint16_t          addr,
+                                    rt_uint8_t           reg,
+                                    const rt_uint8_t     vals[])
+{
+    rt_uint8_t buf[RT_SCCB_LANES_MAX];
+    rt_uint32_t sda, active;
+
+    RT_ASSERT(lanes != RT_NULL);
+    RT_ASSERT(vals != RT_NULL);
+
+    lane_mask &= (1u << lanes->num) - 1;
+    sda = lanes_sda(lanes, lane_mask);
+
+    rt_mutex_take(&lanes->lock, RT_WAITING_FOREVER);
+    active = 0;
+    if (lanes_start(lanes, sda) == RT_EOK)
+    {
+        rt_memset(buf, addr << 1, sizeof(buf));
+        active = lanes_writeb(lanes, lane_mask, buf);
+        if (active)
+        {
+            rt_memset(buf, reg, sizeof(buf));
+            active = lanes_writeb(lanes, active, buf);
+        }
+        if (active)
+            active = lanes_writeb(lanes, active, vals);
+        if (lanes_stop(lanes, sda) != RT_EOK)
+            active = 0;
+    }
+    rt_mutex_release(&lanes->lock);
+
+    if (active != lane_mask)
+        LOG_D("lanes 0x%02x NACK reg 0x%02x", lane_mask & ~active, reg);
+
+    return active;
+}
+
+/**
+ * This function writes the same value to one register on several lanes.
+ *
+ * @param lanes the multi-lane bus.
+ * @param lane_mask the lanes to write, bit n for lane n.
+ * @param addr the 7-bit device address, the same on every lane.
+ * @param reg the register sub-address.
+ * @param val the value to write.
+ *
+ * @return the lanes that acknowledged the whole transaction.
+ */
+rt_uint32_t rt_sccb_lanes_write_reg_all(struct rt_sccb_lanes *lanes,
+                                        rt_uint32_t          lane_mask,
+                                        rt_uint16_t          addr,
+                                        rt_uint8_t           reg,
+                                        rt_uint8_t           val)
+{
+    rt_uint8_t vals[RT_SCCB_LANES_MAX];
+
+    rt_memset(vals, val, sizeof(vals));
+
+    return rt_sccb_lanes_write_reg(lanes, lane_mask, addr, reg, vals);
+}
+
+/**
+ * This function reads one register on several lanes in parallel, a 2-phase
+ * write followed by a 2-phase read.
+ *
+ * @param lanes the multi-lane bus.
+ * @param lane_mask the lanes to read, bit n for lane n.
+ * @param addr the 7-bit device address, the same on every lane.
+ * @param reg the register sub-address.
+ * @param vals the buffer receiving the values, vals[n] for lane n. Must hold
+ *        the number of lanes.
+ *
+ * @return the lanes that were read, vals of other lanes are undefined.
+ */
+rt_uint32_t rt_sccb_lanes_read_reg(struct rt_sccb_lanes *lanes,
+                                   rt_uint32_t          lane_mask,
+                                   rt_uint16_t          addr,
+                                   rt_uint8_t           reg,
+                                   rt_uint8_t           vals[])
+{
+    rt_uint8_t buf[RT_SCCB_LANES_MAX];
+    rt_uint32_t sda, active;
+
+    RT_ASSERT(lanes != RT_NULL);
+    RT_ASSERT(vals != RT_NULL);
+
+    lane_mask &= (1u << lanes->num) - 1;
+    sda = lanes_sda(lanes, lane_mask);
+
+    rt_mutex_take(&lanes->lock, RT_WAITING_FOREVER);
+    active = 0;
+    if (lanes_start(lanes, sda) == RT_EOK)
+    {
+        rt_memset(buf, addr << 1, sizeof(buf));
+        active = lanes_writeb(lanes, lane_mask, buf);
+        if (active)
+        {
+            rt_memset(buf, reg, sizeof(buf));
+            active = lanes_writeb(lanes, active, buf);
+        }
+        if (lanes_stop(lanes, sda) != RT_EOK)
+            active = 0;
+    }
+
+    if (active)
+    {
+        sda = lanes_sda(lanes, active);
+        if (lanes_start(lanes, sda) != RT_EOK)
+        {
+            active = 0;
+        }
+        else
+        {
+            rt_memset(buf, (addr << 1) | 1, sizeof(buf));
+            active = lanes_writeb(lanes, active, buf);
+            if (active)
+                active = lanes_readb(lanes, active, vals);
+            if (lanes_stop(lanes, sda) != RT_EOK)
+                active = 0;
+        }
+    }
+    rt_mutex_release(&lanes->lock);
+
+    return active;
+}
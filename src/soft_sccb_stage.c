@@ -0,0 +1,251 @@
+#include <rtthread.h>
+#include <rthw.h>
+#include "soft_sccb_stage.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+/* the slot of addr/reg in a set, or num if it is not staged */
+static rt_uint32_t stage_find(const struct rt_sccb_stage_entry *set,
+                              rt_uint32_t                      num,
+                              rt_uint16_t                      addr,
+                              rt_uint8_t                       reg)
+{
+    rt_uint32_t i;
+
+    for (i = 0; i < num; i++)
+    {
+        if (set[i].addr == addr && set[i].reg == reg)
+            break;
+    }
+
+    return i;
+}
+
+/**
+ * This function sets up an empty stage for one bus.
+ *
+ * @param stage the stage.
+ * @param bus the SCCB bus.
+ * @param budget_us how soon after a trigger the set has to be on the wire.
+ *        The commit takes the bus with this deadline, ahead of other users.
+ */
+void rt_sccb_stage_init(struct rt_sccb_stage      *stage,
+                        struct rt_sccb_bus_device *bus,
+                        rt_uint32_t               budget_us)
+{
+    RT_ASSERT(stage != RT_NULL);
+    RT_ASSERT(bus != RT_NULL);
+
+    rt_memset(stage, 0, sizeof(*stage));
+    stage->bus       = bus;
+    stage->budget_us = budget_us;
+}
+
+/**
+ * This function stages a register write for the next commit. A write to a
+ * register that is already staged replaces the value in place. It does not
+ * block and may be called from interrupt context.
+ *
+ * @param stage the stage.
+ * @param addr the 7-bit device address, e.g. the client_addr of a client.
+ * @param reg the register sub-address.
+ * @param val the value to write.
+ *
+ * @return RT_EOK when staged, -RT_EFULL when the set is full.
+ */
+rt_err_t rt_sccb_stage_write(struct rt_sccb_stage *stage,
+                             rt_uint16_t          addr,
+                             rt_uint8_t           reg,
+                             rt_uint8_t           val)
+{
+    struct rt_sccb_stage_entry *set;
+    rt_uint32_t slot, num;
+    rt_base_t level;
+
+    RT_ASSERT(stage != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    set  = stage->set[stage->fill];
+    num  = stage->num[stage->fill];
+    slot = stage_find(set, num, addr, reg);
+    if (slot < num)
+    {
+        stage->merges++;
+    }
+    else if (num < RT_SCCB_STAGE_SIZE)
+    {
+        set[slot].addr = addr;
+        set[slot].reg  = reg;
+        stage->num[stage->fill]++;
+    }
+    else
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EFULL;
+    }
+    set[slot].val = val;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+static rt_err_t stage_flush(struct rt_sccb_stage *stage, rt_uint32_t deadline_us)
+{
+    struct rt_sccb_msg msgs[RT_SCCB_STAGE_SIZE];
+    struct rt_sccb_stage_entry *set, *fill;
+    rt_uint32_t take, num, i, slot;
+    rt_size_t done;
+    rt_base_t level;
+    rt_err_t ret;
+
+    ret = rt_sccb_bus_lock_until(stage->bus, deadline_us);
+    if (ret != RT_EOK)
+        return ret;
+
+    /*
+     * flushes are serialized by the bus lock, the other set was emptied by
+     * the previous one
+     */
+    level = rt_hw_interrupt_disable();
+    take = stage->fill;
+    stage->fill = take ^ 1;
+    rt_hw_interrupt_enable(level);
+
+    set = stage->set[take];
+    num = stage->num[take];
+    for (i = 0; i < num; i++)
+    {
+        msgs[i].addr  = set[i].addr;
+        msgs[i].flags = RT_SCCB_WR | RT_SCCB_REG;
+        msgs[i].reg   = set[i].reg;
+        msgs[i].len   = 1;
+        msgs[i].data  = &set[i].val;
+    }
+    done = num ? rt_sccb_transfer(stage->bus, msgs, num) : 0;
+    stage->commits++;
+    stage->writes += done;
+
+    if (done != num)
+    {
+        LOG_E("staged write to device 0x%02x reg 0x%02x failed",
+              set[done].addr, set[done].reg);
+        ret = -RT_EIO;
+
+        /* retry what was not sent with the next commit, unless restaged since */
+        level = rt_hw_interrupt_disable();
+        fill = stage->set[take ^ 1];
+        for (i = done; i < num; i++)
+        {
+            slot = stage_find(fill, stage->num[take ^ 1], set[i].addr, set[i].reg);
+            if (slot == stage->num[take ^ 1] && slot < RT_SCCB_STAGE_SIZE)
+            {
+                fill[slot] = set[i];
+                stage->num[take ^ 1]++;
+            }
+        }
+        rt_hw_interrupt_enable(level);
+    }
+    stage->num[take] = 0;
+    rt_sccb_bus_unlock(stage->bus);
+
+    return ret;
+}
+
+/**
+ * This function sends the staged set now, as one transfer. Writes staged
+ * meanwhile go to the next commit.
+ *
+ * @param stage the stage.
+ *
+ * @return RT_EOK on success, -RT_EIO if a write failed. The writes that
+ *         were not sent stay staged.
+ */
+rt_err_t rt_sccb_stage_commit(struct rt_sccb_stage *stage)
+{
+    RT_ASSERT(stage != RT_NULL);
+
+    return stage_flush(stage, rt_sccb_get_us() + stage->budget_us);
+}
+
+/**
+ * This function drops every staged write.
+ *
+ * @param stage the stage.
+ */
+void rt_sccb_stage_discard(struct rt_sccb_stage *stage)
+{
+    rt_base_t level;
+
+    RT_ASSERT(stage != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    stage->num[stage->fill] = 0;
+    rt_hw_interrupt_enable(level);
+}
+
+static void sccb_stage_entry(void *parameter)
+{
+    struct rt_sccb_stage *stage = (struct rt_sccb_stage *)parameter;
+    rt_err_t ret;
+
+    while (1)
+    {
+        rt_sem_take(&stage->trigger, RT_WAITING_FOREVER);
+
+        ret = stage_flush(stage, stage->trigger_us + stage->budget_us);
+        if (stage->done)
+            stage->done(stage, ret);
+    }
+}
+
+/**
+ * This function starts the commit thread, which sends the staged set on
+ * every rt_sccb_stage_trigger().
+ *
+ * @param stage the stage.
+ * @param name the thread name.
+ * @param stack_size the thread stack size.
+ * @param priority the thread priority.
+ *
+ * @return RT_EOK on success, -RT_ENOMEM if the thread can not be created.
+ */
+rt_err_t rt_sccb_stage_start(struct rt_sccb_stage *stage,
+                             const char           *name,
+                             rt_uint32_t          stack_size,
+                             rt_uint8_t           priority)
+{
+    RT_ASSERT(stage != RT_NULL);
+
+    rt_sem_init(&stage->trigger, name, 0, RT_IPC_FLAG_FIFO);
+    stage->thread = rt_thread_create(name, sccb_stage_entry, stage,
+                                     stack_size, priority, 10);
+    if (stage->thread == RT_NULL)
+    {
+        rt_sem_detach(&stage->trigger);
+
+        return -RT_ENOMEM;
+    }
+
+    return rt_thread_startup(stage->thread);
+}
+
+/**
+ * This function commits the staged set from the commit thread. Call it
+ * from the VSYNC or blanking interrupt of the port.
+ *
+ * @param stage the stage, started with rt_sccb_stage_start().
+ */
+void rt_sccb_stage_trigger(struct rt_sccb_stage *stage)
+{
+    RT_ASSERT(stage != RT_NULL);
+
+    stage->trigger_us = rt_sccb_get_us();
+    rt_sem_release(&stage->trigger);
+}
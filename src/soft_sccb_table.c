@@ -0,0 +1,117 @@
+#include <rtthread.h>
+#include "soft_sccb_table.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#define US_PER_TICK           (1000000 / RT_TICK_PER_SECOND)
+
+static rt_err_t table_entry(struct rt_sccb_bus_device      *bus,
+                            rt_uint16_t                    addr,
+                            const struct rt_sccb_reg_entry *entry)
+{
+    rt_uint8_t cur;
+    rt_err_t ret;
+
+    /* the bus lock is held by the caller, the register calls nest under it */
+    switch (entry->op & RT_SCCB_TAB_OP_MSK)
+    {
+    case RT_SCCB_TAB_OP_WRITE:
+        ret = rt_sccb_write_reg(bus, addr, entry->reg, entry->val);
+        break;
+    case RT_SCCB_TAB_OP_MASK:
+        ret = rt_sccb_update_bits(bus, addr, entry->reg, entry->mask, entry->val);
+        break;
+    case RT_SCCB_TAB_OP_DELAY:
+        rt_thread_mdelay((entry->mask << 8) | entry->val);
+        return RT_EOK;
+    case RT_SCCB_TAB_OP_WAIT:
+        return rt_sccb_wait_reg(bus, addr, entry->reg, entry->mask, entry->val,
+                                bus->timeout * US_PER_TICK, RT_NULL);
+    case RT_SCCB_TAB_OP_VERIFY:
+        ret = rt_sccb_read_reg(bus, addr, entry->reg, &cur);
+        if (ret == RT_EOK && (cur & entry->mask) != entry->val)
+            ret = -RT_ERROR;
+        return ret;
+    case RT_SCCB_TAB_OP_YIELD:
+        rt_sccb_bus_yield(bus);
+        return RT_EOK;
+    default:
+        return -RT_EINVAL;
+    }
+
+    /* WRITE has mask 0xff, so this compares what either op wrote */
+    if (ret == RT_EOK && (entry->op & RT_SCCB_TAB_F_VERIFY))
+    {
+        ret = rt_sccb_read_reg(bus, addr, entry->reg, &cur);
+        if (ret == RT_EOK && (cur & entry->mask) != (entry->val & entry->mask))
+            ret = -RT_ERROR;
+    }
+
+    return ret;
+}
+
+/**
+ * This function replays an init table against one device, holding the
+ * bus lock for the whole table. DELAY and WAIT entries sleep with the lock
+ * held too, so every other user of the bus waits them out. More urgent bus
+ * users only slip in at YIELD entries, so place them where the device state
+ * allows it, e.g. not between a bank select and the registers behind it. A
+ * session held by the caller around the call disables them.
+ *
+ * @param bus the SCCB bus.
+ * @param addr the 7-bit device address.
+ * @param table the table entries.
+ * @param count the number of entries, the walk also stops at an END entry.
+ * @param fail_index the index of the failing entry, or the number of
+ *        entries walked on success. May be RT_NULL.
+ *
+ * @return RT_EOK on success, -RT_EIO on a bus error, -RT_ETIMEOUT when a
+ *         WAIT entry times out, -RT_ERROR on a verify mismatch.
+ */
+rt_err_t rt_sccb_write_table(struct rt_sccb_bus_device       *bus,
+                             rt_uint16_t                     addr,
+                             const struct rt_sccb_reg_entry  *table,
+                             rt_size_t                       count,
+                             rt_size_t                       *fail_index)
+{
+    rt_size_t i;
+    rt_err_t ret = RT_EOK;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(table != RT_NULL);
+
+    if (!bus->ops->master_xfer)
+    {
+        LOG_E("SCCB bus operation not supported");
+
+        return -RT_ENOSYS;
+    }
+
+    ret = rt_sccb_bus_lock(bus);
+    if (ret != RT_EOK)
+        return ret;
+    for (i = 0; i < count; i++)
+    {
+        if ((table[i].op & RT_SCCB_TAB_OP_MSK) == RT_SCCB_TAB_OP_END)
+            break;
+        ret = table_entry(bus, addr, &table[i]);
+        if (ret != RT_EOK)
+        {
+            LOG_E("init table entry %d (reg 0x%02x) failed: %d",
+                  i, table[i].reg, ret);
+            break;
+        }
+    }
+    rt_sccb_bus_unlock(bus);
+
+    if (fail_index)
+        *fail_index = i;
+
+    return ret;
+}
@@ -0,0 +1,239 @@
+#include <rtthread.h>
+#include "soft_sccb_trace.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#ifdef RT_SCCB_USING_TRACE
+
+#define TRACE_LINE_MAX        48
+
+static void trace_printf(rt_sccb_trace_out_t out, void *ctx, const char *fmt, ...)
+{
+    char line[TRACE_LINE_MAX];
+    va_list args;
+
+    va_start(args, fmt);
+    rt_vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    out(ctx, line);
+}
+
+static void trace_export_log(const struct rt_sccb_trace_event *ev,
+                             rt_uint32_t                      first,
+                             rt_uint32_t                      last,
+                             rt_sccb_trace_out_t              out,
+                             void                             *ctx)
+{
+    rt_uint32_t i, start = 0, stretch = 0;
+    rt_bool_t open = RT_FALSE;
+    const struct rt_sccb_trace_event *e;
+
+    for (i = first; i != last; i++)
+    {
+        e = &ev[i & (RT_SCCB_TRACE_SIZE - 1)];
+        if (!open && e->type != RT_SCCB_TRACE_START)
+        {
+            /* the ring wrapped inside a transaction */
+            trace_printf(out, ctx, "%10u us  ...", e->time_us);
+            start = e->time_us;
+            open = RT_TRUE;
+        }
+
+        switch (e->type)
+        {
+        case RT_SCCB_TRACE_START:
+            if (open)
+            {
+                /* repeated start, or a retry after a NACKed device ID */
+                trace_printf(out, ctx, " Sr");
+                break;
+            }
+            trace_printf(out, ctx, "%10u us  S", e->time_us);
+            start = e->time_us;
+            open = RT_TRUE;
+            break;
+        case RT_SCCB_TRACE_STOP:
+            trace_printf(out, ctx, " P  (%u us)\n", e->time_us - start);
+            open = RT_FALSE;
+            break;
+        case RT_SCCB_TRACE_WRITE:
+            trace_printf(out, ctx, " %02x%c", e->data, e->ack ? '+' : '-');
+            break;
+        case RT_SCCB_TRACE_READ:
+            trace_printf(out, ctx, " [%02x]", e->data);
+            break;
+        case RT_SCCB_TRACE_STRETCH_BEGIN:
+            stretch = e->time_us;
+            break;
+        case RT_SCCB_TRACE_STRETCH_END:
+            trace_printf(out, ctx, " ~%uus", e->time_us - stretch);
+            break;
+        case RT_SCCB_TRACE_TIMEOUT:
+            trace_printf(out, ctx, " TIMEOUT");
+            break;
+        case RT_SCCB_TRACE_RETRY:
+            trace_printf(out, ctx, " RETRY");
+            break;
+        default:
+            break;
+        }
+    }
+    if (open)
+        out(ctx, "\n");
+}
+
+/* signals: busy (start..stop), data[7:0], ack, stretch, retry pulse */
+static void trace_export_vcd(const struct rt_sccb_trace_event *ev,
+                             rt_uint32_t                      first,
+                             rt_uint32_t                      last,
+                             rt_sccb_trace_out_t              out,
+                             void                             *ctx)
+{
+    const struct rt_sccb_trace_event *e;
+    rt_uint32_t i, t0, now, t = 0;
+    rt_bool_t retry = RT_FALSE;
+    rt_int32_t b;
+
+    out(ctx, "$timescale 1us $end\n");
+    out(ctx, "$scope module sccb $end\n");
+    out(ctx, "$var wire 1 ! busy $end\n");
+    out(ctx, "$var wire 8 \" data $end\n");
+    out(ctx, "$var wire 1 # ack $end\n");
+    out(ctx, "$var wire 1 $ stretch $end\n");
+    out(ctx, "$var wire 1 % retry $end\n");
+    out(ctx, "$upscope $end\n");
+    out(ctx, "$enddefinitions $end\n");
+    out(ctx, "#0\n$dumpvars\n0!\nbxxxxxxxx \"\nx#\n0$\n0%\n$end\n");
+
+    if (first == last)
+        return;
+
+    t0 = ev[first & (RT_SCCB_TRACE_SIZE - 1)].time_us;
+    for (i = first; i != last; i++)
+    {
+        e = &ev[i & (RT_SCCB_TRACE_SIZE - 1)];
+        now = e->time_us - t0;
+        if (now > t)
+        {
+            trace_printf(out, ctx, "#%u\n", now);
+            t = now;
+        }
+        if (retry)
+        {
+            out(ctx, "0%\n");
+            retry = RT_FALSE;
+        }
+
+        switch (e->type)
+        {
+        case RT_SCCB_TRACE_START:
+            out(ctx, "1!\n");
+            break;
+        case RT_SCCB_TRACE_STOP:
+            out(ctx, "0!\n");
+            break;
+        case RT_SCCB_TRACE_WRITE:
+        case RT_SCCB_TRACE_READ:
+            out(ctx, "b");
+            for (b = 7; b >= 0; b--)
+                out(ctx, ((e->data >> b) & 1) ? "1" : "0");
+            out(ctx, " \"\n");
+            out(ctx, e->ack ? "1#\n" : "0#\n");
+            break;
+        case RT_SCCB_TRACE_STRETCH_BEGIN:
+            out(ctx, "1$\n");
+            break;
+        case RT_SCCB_TRACE_STRETCH_END:
+        case RT_SCCB_TRACE_TIMEOUT:
+            out(ctx, "0$\n");
+            break;
+        case RT_SCCB_TRACE_RETRY:
+            out(ctx, "1%\n");
+            retry = RT_TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * This function writes the trace ring out, oldest event first. The bus is
+ * locked meanwhile, so the ring does not move under the export.
+ *
+ * @param bus the SCCB bus.
+ * @param format RT_SCCB_TRACE_FMT_LOG or RT_SCCB_TRACE_FMT_VCD.
+ * @param out the output routine, called once per text fragment.
+ * @param ctx passed to out.
+ *
+ * @return RT_EOK on success, -RT_EINVAL for an unknown format.
+ */
+rt_err_t rt_sccb_trace_export(struct rt_sccb_bus_device *bus,
+                              rt_uint8_t               format,
+                              rt_sccb_trace_out_t      out,
+                              void                     *ctx)
+{
+    rt_uint32_t first, last;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(out != RT_NULL);
+
+    if (format != RT_SCCB_TRACE_FMT_LOG && format != RT_SCCB_TRACE_FMT_VCD)
+        return -RT_EINVAL;
+
+    if (rt_sccb_bus_lock(bus) != RT_EOK)
+        return -RT_EBUSY;
+    last  = bus->trace.head;
+    first = (last > RT_SCCB_TRACE_SIZE) ? last - RT_SCCB_TRACE_SIZE : 0;
+    if (format == RT_SCCB_TRACE_FMT_LOG)
+        trace_export_log(bus->trace.ring, first, last, out, ctx);
+    else
+        trace_export_vcd(bus->trace.ring, first, last, out, ctx);
+    rt_sccb_bus_unlock(bus);
+
+    return RT_EOK;
+}
+
+/**
+ * This function drops every recorded event.
+ *
+ * @param bus the SCCB bus.
+ *
+ * @return RT_EOK.
+ */
+rt_err_t rt_sccb_trace_clear(struct rt_sccb_bus_device *bus)
+{
+    RT_ASSERT(bus != RT_NULL);
+
+    if (rt_sccb_bus_lock(bus) != RT_EOK)
+        return -RT_EBUSY;
+    bus->trace.head = 0;
+    rt_sccb_bus_unlock(bus);
+
+    return RT_EOK;
+}
+
+#else
+
+rt_err_t rt_sccb_trace_export(struct rt_sccb_bus_device *bus,
+                              rt_uint8_t               format,
+                              rt_sccb_trace_out_t      out,
+                              void                     *ctx)
+{
+    LOG_E("SCCB trace not enabled, define RT_SCCB_USING_TRACE");
+
+    return -RT_ENOSYS;
+}
+
+rt_err_t rt_sccb_trace_clear(struct rt_sccb_bus_device *bus)
+{
+    return -RT_ENOSYS;
+}
+
+#endif /* RT_SCCB_USING_TRACE */
@@ -0,0 +1,572 @@
+#include <rtthread.h>
+#include "soft_sccb_wave.h"
+
+#define DBG_TAG               "SCCB"
+#ifdef RT_SCCB_DEBUG
+#define DBG_LVL               DBG_LOG
+#else
+#define DBG_LVL               DBG_INFO
+#endif
+#include <rtdbg.h>
+
+#define US_PER_TICK           (1000000 / RT_TICK_PER_SECOND)
+
+#define SDA                   RT_SCCB_LINE_SDA
+#define SCL                   RT_SCCB_LINE_SCL
+#define SAMPLE                RT_SCCB_WAVE_SAMPLE
+#define WAIT                  RT_SCCB_WAVE_WAIT
+
+#define SYM(q0, q1, q2, q3)                                             \
+    ((rt_uint32_t)(q0) | ((rt_uint32_t)(q1) << 8) |                     \
+     ((rt_uint32_t)(q2) << 16) | ((rt_uint32_t)(q3) << 24))
+
+/* SDA settles while SCL is low, SCL is high for the middle two slots */
+#define SYM_BIT(d)            SYM((d) * SDA, (d) * SDA | SCL | WAIT, (d) * SDA | SCL, (d) * SDA)
+/* SDA released and sampled, for read bits and the slave's ACK */
+#define SYM_SAMPLE            SYM(SDA, SDA | SCL | WAIT, SDA | SCL | SAMPLE, SDA)
+#define SYM_START             SYM(SDA | SCL | WAIT, SDA | SCL, SCL, 0)
+#define SYM_RESTART           SYM(SDA, SDA | SCL | WAIT, SCL, 0)
+#define SYM_STOP              SYM(0, SCL | WAIT, SDA | SCL, SDA | SCL)
+
+
+#define NIBBLE(n)                                                       \
+    { SYM_BIT(((n) >> 3) & 1), SYM_BIT(((n) >> 2) & 1),                 \
+      SYM_BIT(((n) >> 1) & 1), SYM_BIT((n) & 1) }
+
+/* the bit symbols of every nibble, a byte is two lookups instead of eight branches */
+static const rt_uint32_t wave_nibble[16][4] =
+{
+    NIBBLE(0x0), NIBBLE(0x1), NIBBLE(0x2), NIBBLE(0x3),
+    NIBBLE(0x4), NIBBLE(0x5), NIBBLE(0x6), NIBBLE(0x7),
+    NIBBLE(0x8), NIBBLE(0x9), NIBBLE(0xa), NIBBLE(0xb),
+    NIBBLE(0xc), NIBBLE(0xd), NIBBLE(0xe), NIBBLE(0xf),
+};
+
+/* a byte out and the slave's ACK sampled */
+static void wave_put_write(struct rt_sccb_wave *wave, rt_uint8_t byte)
+{
+    rt_uint32_t *sym = &wave->sym[wave->len];
+
+    rt_memcpy(&sym[0], wave_nibble[byte >> 4], sizeof(wave_nibble[0]));
+    rt_memcpy(&sym[4], wave_nibble[byte & 0x0f], sizeof(wave_nibble[0]));
+    sym[8] = SYM_SAMPLE;
+    wave->len += 9;
+}
+
+/* a byte in, ended with ACK to keep the slave sending or NACK */
+static void wave_put_read(struct rt_sccb_wave *wave, rt_bool_t ack)
+{
+    rt_uint32_t *sym = &wave->sym[wave->len];
+    rt_uint8_t i;
+
+    for (i = 0; i < 8; i++)
+        sym[i] = SYM_SAMPLE;
+    sym[8] = SYM_BIT(ack ? 0 : 1);
+    wave->len += 9;
+}
+
+rt_inline rt_bool_t wave_has_reg(const struct rt_sccb_msg *msg)
+{
+    return !(msg->flags & RT_SCCB_RD) && (msg->flags & RT_SCCB_REG);
+}
+
+/* symbols ahead of the data, none when the message is continued */
+static rt_uint32_t wave_head_syms(const struct rt_sccb_msg *msg, rt_uint16_t skip)
+{
+    rt_uint32_t bytes = 1;
+
+    if (skip)
+        return 0;
+    if (wave_has_reg(msg))
+        bytes += (msg->flags & RT_SCCB_REG16) ? 2 : 1;
+
+    return 1 + bytes * 9;
+}
+
+/* symbols of a message from data byte skip on, with the start and the stop it may have */
+static rt_uint32_t wave_msg_syms(const struct rt_sccb_msg *msg, rt_uint16_t skip)
+{
+    rt_uint32_t syms = wave_head_syms(msg, skip) + 1;
+
+    if (msg->data != RT_NULL)
+        syms += (RT_SCCB_MSG_LEN(msg) - skip) * 9;
+
+    return syms;
+}
+
+rt_inline rt_bool_t wave_stop_after(struct rt_sccb_msg msgs[], rt_uint32_t i, rt_uint32_t num)
+{
+    return !(msgs[i].flags & RT_SCCB_NO_STOP) || i + 1 == num;
+}
+
+/**
+ * This function compiles messages into the waveform buffer, with the same
+ * framing the bit engine uses. Messages are compiled up to the last stop
+ * that fits, the rest is left for the next call. When not even one
+ * transaction fits, the data phase that overflows is cut at the buffer end
+ * and part tells how many of its bytes were compiled. The call for the next
+ * buffer starts at the cut message with offset advanced by part.
+ *
+ * @param wave the waveform, offset set to the data bytes of msgs[0]
+ *        compiled before.
+ * @param msgs the messages.
+ * @param num the number of messages.
+ *
+ * @return the number of messages compiled whole, 0 if the first one does
+ *         not fit and could not be cut either.
+ */
+rt_uint32_t rt_sccb_wave_compile(struct rt_sccb_wave *wave,
+                                 struct rt_sccb_msg  msgs[],
+                                 rt_uint32_t         num)
+{
+    struct rt_sccb_msg *msg;
+    rt_uint32_t i, mark = 0;
+    rt_uint16_t mark_len = 0, n, skip, end;
+    rt_bool_t idle = (wave->offset == 0);
+
+    RT_ASSERT(wave != RT_NULL);
+    RT_ASSERT(msgs != RT_NULL);
+
+    wave->len  = 0;
+    wave->part = 0;
+    for (i = 0; i < num; i++)
+    {
+        msg  = &msgs[i];
+        skip = (i == 0) ? wave->offset : 0;
+        end  = RT_SCCB_MSG_LEN(msg);
+        if (wave->len + wave_msg_syms(msg, skip) > RT_SCCB_WAVE_SYMS)
+        {
+            /* cut only a transaction that has the buffer to itself */
+            if (mark != 0 || msg->data == RT_NULL ||
+                wave->len + wave_head_syms(msg, skip) + 9 > RT_SCCB_WAVE_SYMS)
+                break;
+            end = skip + (RT_SCCB_WAVE_SYMS - wave->len - wave_head_syms(msg, skip)) / 9;
+            wave->part = end - skip;
+        }
+
+        if (!skip && !(msg->flags & RT_SCCB_NO_START))
+        {
+            wave->sym[wave->len++] = idle ? SYM_START : SYM_RESTART;
+            idle = RT_FALSE;
+            wave_put_write(wave, (msg->addr << 1) | ((msg->flags & RT_SCCB_RD) ? 1 : 0));
+        }
+        if (!skip && wave_has_reg(msg))
+        {
+            if (msg->flags & RT_SCCB_REG16)
+                wave_put_write(wave, msg->reg >> 8);
+            wave_put_write(wave, msg->reg & 0xff);
+        }
+        if (msg->data != RT_NULL)
+        {
+            for (n = skip; n < end; n++)
+            {
+                if (msg->flags & RT_SCCB_RD)
+                    wave_put_read(wave, n + 1 < RT_SCCB_MSG_LEN(msg));
+                else
+                    wave_put_write(wave, msg->data[n]);
+            }
+        }
+
+        /* the transaction stays open, the next buffer goes on from here */
+        if (wave->part)
+            return i;
+
+        if (wave_stop_after(msgs, i, num))
+        {
+            wave->sym[wave->len++] = SYM_STOP;
+            idle = RT_TRUE;
+            mark = i + 1;
+            mark_len = wave->len;
+        }
+    }
+    wave->len = mark_len;
+
+    return mark;
+}
+
+static void wave_drive(struct rt_sccb_wave *wave, rt_uint8_t values)
+{
+    struct rt_sccb_ops *ops = wave->ops;
+    rt_uint8_t change = (wave->lines ^ values) & (SDA | SCL);
+
+    if (!change)
+        return;
+
+    if (ops->set_lines)
+    {
+        ops->set_lines(ops->data, change, values & change);
+    }
+    else
+    {
+        if ((change & SCL) && !(values & SCL))
+            ops->set_scl(ops->data, 0);
+        if (change & SDA)
+            ops->set_sda(ops->data, (values & SDA) ? 1 : 0);
+        if ((change & SCL) && (values & SCL))
+            ops->set_scl(ops->data, 1);
+    }
+    wave->lines = (wave->lines & ~change) | (values & change);
+}
+
+static void wave_finish(struct rt_sccb_wave *wave, rt_err_t status)
+{
+    if (status != RT_EOK)
+    {
+        /* let go of the bus, SCL first so a low SDA ends in a stop */
+        wave_drive(wave, wave->lines | SCL);
+        wave_drive(wave, SDA | SCL);
+    }
+    wave->status = status;
+    wave->done   = 1;
+}
+
+static void wave_slot_delay(struct rt_sccb_wave *wave)
+{
+    struct rt_sccb_ops *ops = wave->ops;
+
+    if (!wave->slot_ns)
+        return;
+    if (ops->ndelay)
+        ops->ndelay(wave->slot_ns);
+    else
+        ops->udelay((wave->slot_ns + 999) / 1000);
+}
+
+/* close a transaction a cut message left open, once the slave has NACKed */
+static void wave_stop(struct rt_sccb_wave *wave)
+{
+    wave_drive(wave, 0);
+    wave_slot_delay(wave);
+    wave_drive(wave, SCL);
+    wave_slot_delay(wave);
+    wave_drive(wave, SDA | SCL);
+    wave->ops->lines = wave->lines;
+}
+
+/**
+ * This function plays the next slot of the waveform, from a periodic timer
+ * interrupt or the replay loop. A slot that released SCL is held while a
+ * slave stretches the clock.
+ *
+ * @param wave the waveform.
+ *
+ * @return RT_TRUE once the waveform has finished or was aborted.
+ */
+rt_bool_t rt_sccb_wave_tick(struct rt_sccb_wave *wave)
+{
+    struct rt_sccb_ops *ops = wave->ops;
+    rt_uint8_t slot;
+
+    if (wave->done)
+        return RT_TRUE;
+
+    slot = (wave->sym[wave->pos] >> (wave->slot << 3)) & 0xff;
+    wave_drive(wave, slot);
+
+    if ((slot & WAIT) && ops->get_scl && !ops->get_scl(ops->data))
+    {
+        if (wave->stall++ == 0)
+            ops->stretches++;
+        if (wave->stall > wave->stall_max)
+        {
+            ops->stretch_timeouts++;
+            wave_finish(wave, -RT_ETIMEOUT);
+
+            return RT_TRUE;
+        }
+
+        return RT_FALSE;
+    }
+    wave->stall = 0;
+
+    if (slot & SAMPLE)
+    {
+        if (ops->get_sda(ops->data))
+            wave->capture[wave->samples >> 3] |= 0x80 >> (wave->samples & 7);
+        wave->samples++;
+    }
+
+    if (++wave->slot == 4)
+    {
+        wave->slot = 0;
+        if (++wave->pos == wave->len)
+        {
+            wave_finish(wave, RT_EOK);
+
+            return RT_TRUE;
+        }
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * This function clocks the compiled waveform out, through the timer
+ * backend when the port has one, else in a delay loop. The slot period is
+ * a quarter of the SCL period of the timing profile, or half of delay_us.
+ *
+ * @param wave the waveform.
+ *
+ * @return RT_EOK on success, -RT_ETIMEOUT if a slave stretched the clock
+ *         past the deadline.
+ */
+rt_err_t rt_sccb_wave_run(struct rt_sccb_wave *wave)
+{
+    struct rt_sccb_ops *ops;
+    rt_uint32_t timeout_us;
+    rt_err_t ret;
+
+    RT_ASSERT(wave != RT_NULL);
+    RT_ASSERT(wave->ops != RT_NULL);
+
+    ops = wave->ops;
+    if (ops->timing)
+        wave->slot_ns = (ops->timing->scl_high_ns > ops->timing->scl_low_ns ?
+                         ops->timing->scl_high_ns : ops->timing->scl_low_ns) >> 1;
+    else
+        wave->slot_ns = ops->delay_us * 500;
+    timeout_us = ops->timeout_us ? ops->timeout_us : ops->timeout * US_PER_TICK;
+    wave->stall_max = (rt_uint32_t)((rt_uint64_t)timeout_us * 1000 /
+                                    (wave->slot_ns ? wave->slot_ns : 1));
+
+    wave->pos     = 0;
+    wave->slot    = 0;
+    wave->samples = 0;
+    wave->stall   = 0;
+    wave->status  = RT_EOK;
+    wave->done    = (wave->len == 0);
+    rt_memset(wave->capture, 0, sizeof(wave->capture));
+    /* start from the bus idle state the bit engine leaves behind, or go on where the last buffer stopped */
+    if (!wave->offset)
+        wave->lines = SDA | SCL;
+
+    if (wave->play && !wave->done)
+    {
+        ret = wave->play(wave);
+        if (ret != RT_EOK)
+            return ret;
+    }
+    else
+    {
+        while (!rt_sccb_wave_tick(wave))
+            wave_slot_delay(wave);
+    }
+
+    /* the bit engine's line shadow went stale meanwhile */
+    ops->lines = wave->lines;
+    ops->lines_known = SDA | SCL;
+
+    return wave->status;
+}
+
+/* the next captured bit */
+rt_inline rt_uint8_t wave_sample(struct rt_sccb_wave *wave, rt_uint16_t *pos)
+{
+    rt_uint16_t n = (*pos)++;
+
+    return (wave->capture[n >> 3] >> (7 - (n & 7))) & 1;
+}
+
+/**
+ * This function turns the samples of a played waveform back into ACKs and
+ * read data. The waveform is fixed once compiled, so bytes after a NACK
+ * were still clocked out, but are not counted as transferred. A message cut
+ * by rt_sccb_wave_compile() is passed as the last one, and decoded from
+ * offset for part bytes.
+ *
+ * @param wave the waveform.
+ * @param msgs the messages the waveform was compiled from.
+ * @param num the number of messages compiled, with the cut one.
+ *
+ * @return the number of messages that completed, as rt_sccb_transfer(),
+ *         counting the cut one if its part went through.
+ */
+rt_uint32_t rt_sccb_wave_decode(struct rt_sccb_wave *wave,
+                                struct rt_sccb_msg  msgs[],
+                                rt_uint32_t         num)
+{
+    struct rt_sccb_msg *msg;
+    rt_uint16_t pos = 0, n, len, skip;
+    rt_uint32_t i;
+    rt_uint8_t val, b, subs;
+
+    RT_ASSERT(wave != RT_NULL);
+    RT_ASSERT(msgs != RT_NULL);
+
+    wave->bytes = 0;
+    wave->nacks = 0;
+    for (i = 0; i < num; i++)
+    {
+        msg  = &msgs[i];
+        skip = (i == 0) ? wave->offset : 0;
+        if (!skip && !(msg->flags & RT_SCCB_NO_START))
+        {
+            wave->bytes++;
+            if (wave_sample(wave, &pos))
+            {
+                LOG_D("receive NACK from device addr 0x%02x msg %d", msg->addr, i);
+                wave->nacks++;
+                break;
+            }
+        }
+        subs = 0;
+        if (!skip && wave_has_reg(msg))
+            subs = (msg->flags & RT_SCCB_REG16) ? 2 : 1;
+        for (b = 0; b < subs; b++)
+        {
+            wave->bytes++;
+            if (wave_sample(wave, &pos))
+                break;
+        }
+        if (b < subs)
+        {
+            LOG_D("receive NACK for sub-address 0x%04x", msg->reg);
+            wave->nacks++;
+            break;
+        }
+        if (msg->data == RT_NULL)
+            continue;
+
+        len = RT_SCCB_MSG_LEN(msg);
+        if (wave->part && i + 1 == num)
+            len = skip + wave->part;
+        for (n = skip; n < len; n++)
+        {
+            wave->bytes++;
+            if (msg->flags & RT_SCCB_RD)
+            {
+                for (val = 0, b = 0; b < 8; b++)
+                    val = (val << 1) | wave_sample(wave, &pos);
+                msg->data[n] = val;
+            }
+            else if (wave_sample(wave, &pos))
+            {
+                wave->nacks++;
+                if (!(msg->flags & RT_SCCB_IGNORE_NACK))
+                {
+                    LOG_E("receive NACK for data byte %d of msg %d", n, i);
+                    break;
+                }
+            }
+        }
+        if (n < len)
+            break;
+    }
+
+    return i;
+}
+
+static rt_size_t wave_xfer(struct rt_sccb_bus_device *bus,
+                           struct rt_sccb_msg         msgs[],
+                           rt_uint32_t                num)
+{
+    struct rt_sccb_wave *wave = (struct rt_sccb_wave *)bus->priv;
+    struct rt_sccb_ops *ops = wave->ops;
+    const struct rt_sccb_timing *timing = ops->timing;
+    rt_uint32_t timeout_us = ops->timeout_us;
+    struct rt_sccb_client *client;
+    rt_uint32_t stretches = ops->stretches;
+    rt_uint32_t timeouts = ops->stretch_timeouts;
+    rt_uint32_t done = 0, n, ok, part;
+    rt_err_t ret;
+
+    /* a split data phase goes on through wave->offset, never through the flag */
+    if (num > 0 && (msgs[0].flags & RT_SCCB_NO_START))
+    {
+        LOG_E("msg 0 has RT_SCCB_NO_START, there is no transaction to continue");
+
+        return 0;
+    }
+
+    wave->offset = 0;
+    while (done < num)
+    {
+        /* a waveform never spans two devices, each runs at its own settings */
+        n = rt_sccb_wave_compile(wave, &msgs[done], rt_sccb_device_run(&msgs[done], num - done));
+        if (n == 0 && wave->part == 0)
+        {
+            LOG_E("msg %d does not fit the waveform buffer", done);
+            break;
+        }
+        client = rt_sccb_client_find(bus, msgs[done].addr);
+        ops->timing = rt_sccb_rate_timing(ops, msgs[done].addr, timing);
+        if (client && client->timing)
+            ops->timing = client->timing;
+        if (client && client->timeout_us)
+            ops->timeout_us = client->timeout_us;
+        ret = rt_sccb_wave_run(wave);
+        ops->timing     = timing;
+        ops->timeout_us = timeout_us;
+        if (ret != RT_EOK)
+            break;
+        part = wave->part ? 1 : 0;
+        ok = rt_sccb_wave_decode(wave, &msgs[done], n + part);
+        bus->stats.bytes += wave->bytes;
+        bus->stats.nacks += wave->nacks;
+        if (ok != n + part)
+        {
+            if (part)
+                wave_stop(wave);
+            done += ok;
+            break;
+        }
+        /* a cut message goes on in the next buffer */
+        wave->offset = (n == 0 ? wave->offset : 0) + wave->part;
+        done += n;
+    }
+    wave->offset = 0;
+
+    bus->stats.stretches += ops->stretches - stretches;
+    bus->stats.timeouts  += ops->stretch_timeouts - timeouts;
+
+    return done;
+}
+
+static const struct rt_sccb_bus_device_ops wave_bus_ops =
+{
+    wave_xfer,
+    RT_NULL
+};
+
+/**
+ * This function registers a bus that plays precompiled waveforms instead of
+ * running the bit engine. bus->priv must point to a struct rt_sccb_wave
+ * whose ops are filled in. Device ID retries are not supported.
+ *
+ * @param bus the SCCB bus.
+ * @param bus_name the bus device name.
+ *
+ * @return the error code, RT_EOK on successfully.
+ */
+rt_err_t rt_sccb_add_wave_bus(struct rt_sccb_bus_device *bus,
+                              const char               *bus_name)
+{
+    struct rt_sccb_wave *wave = (struct rt_sccb_wave *)bus->priv;
+
+    RT_ASSERT(wave != RT_NULL);
+    RT_ASSERT(wave->ops != RT_NULL);
+
+    wave->len    = 0;
+    wave->offset = 0;
+    wave->done   = 1;
+    bus->ops = &wave_bus_ops;
+
+    return rt_sccb_bus_device_register(bus, bus_name);
+}
+
+/**
+ * This function returns the line routines a waveform bus plays through.
+ *
+ * @param bus the SCCB bus.
+ *
+ * @return the ops, RT_NULL if the bus is not a waveform bus.
+ */
+struct rt_sccb_ops *rt_sccb_wave_bus_ops(struct rt_sccb_bus_device *bus)
+{
+    RT_ASSERT(bus != RT_NULL);
+
+    if (bus->ops != &wave_bus_ops)
+        return RT_NULL;
+
+    return ((struct rt_sccb_wave *)bus->priv)->ops;
+}